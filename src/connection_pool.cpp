@@ -1,6 +1,8 @@
 #include <godot_cpp/variant/string.hpp>
 #include "connection_pool.h"
+#include "query_tracer.h"
 #include <godot_cpp/variant/utility_functions.hpp>
+#include <chrono>
 
 namespace godot {
 
@@ -23,6 +25,10 @@ ConnectionPool::ConnectionPool(const String& p_connection_string, int p_pool_siz
             UtilityFunctions::print("Exception creating connection: ", e.what());
         }
     }
+    live_connections = (int)connections.size();
+    if (live_connections == 0) {
+        UtilityFunctions::print("Connection pool has no open connections.");
+    }
     UtilityFunctions::print("Connection pool initialized.");
 }
 
@@ -30,35 +36,117 @@ ConnectionPool::~ConnectionPool() {
     shutdown();
 }
 
-pqxx::connection* ConnectionPool::acquire() {
+pqxx::connection* ConnectionPool::acquire(int p_timeout_msec) {
+    TraceSpan span("acquire");
     std::unique_lock<std::mutex> lock(mutex);
-    condition.wait(lock, [this]{ return !connections.empty() || shutting_down; });
-    if (shutting_down && connections.empty()) {
+    // With no live connections nothing will ever be released, so fail fast
+    bool ready = condition.wait_for(lock, std::chrono::milliseconds(p_timeout_msec), [this]{
+        return !connections.empty() || shutting_down || live_connections == 0;
+    });
+    if (!ready) {
+        UtilityFunctions::print("Timed out waiting for a pooled connection after ", p_timeout_msec, " ms.");
+        return nullptr;
+    }
+    if (connections.empty()) {
+        return nullptr;
+    }
+    pqxx::connection* conn = connections.front();
+    connections.pop();
+    if (verbose.load(std::memory_order_relaxed)) {
+        UtilityFunctions::print("Connection acquired from pool. Pool size: ", (int)connections.size());
+    }
+    return conn;
+}
+
+pqxx::connection* ConnectionPool::try_acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (shutting_down || connections.empty()) {
         return nullptr;
     }
     pqxx::connection* conn = connections.front();
     connections.pop();
-    UtilityFunctions::print("Connection acquired from pool. Pool size: ", (int)connections.size());
     return conn;
 }
 
 void ConnectionPool::release(pqxx::connection* connection) {
     std::lock_guard<std::mutex> lock(mutex);
+    if (shutting_down) {
+        scratch_buffers.erase(connection);
+        delete connection;
+        return;
+    }
     connections.push(connection);
-    UtilityFunctions::print("Connection released to pool. Pool size: ", (int)connections.size());
+    if (verbose.load(std::memory_order_relaxed)) {
+        UtilityFunctions::print("Connection released to pool. Pool size: ", (int)connections.size());
+    }
     condition.notify_one();
 }
 
+void ConnectionPool::discard(pqxx::connection* connection) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        scratch_buffers.erase(connection);
+        if (!shutting_down) {
+            --live_connections;
+        }
+    }
+    delete connection;
+
+    // Connect outside the lock so other threads keep using the pool meanwhile.
+    pqxx::connection* replacement = nullptr;
+    try {
+        replacement = new pqxx::connection(connection_string.utf8().get_data());
+        if (!replacement->is_open()) {
+            delete replacement;
+            replacement = nullptr;
+        }
+    } catch (const std::exception& e) {
+        UtilityFunctions::print("Exception replacing broken connection: ", e.what());
+        replacement = nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (replacement && !shutting_down) {
+        ++live_connections;
+        connections.push(replacement);
+        condition.notify_one();
+        return;
+    }
+    delete replacement;
+    if (live_connections == 0) {
+        UtilityFunctions::print("Could not replace broken connection. No connections left in pool.");
+        // Wake waiters so they give up instead of waiting for a release that never comes
+        condition.notify_all();
+    } else {
+        UtilityFunctions::print("Could not replace broken connection. Pool shrunk.");
+    }
+}
+
+QueryScratch& ConnectionPool::scratch(pqxx::connection* connection) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<QueryScratch>& buffers = scratch_buffers[connection];
+    if (!buffers) {
+        buffers = std::make_unique<QueryScratch>();
+    }
+    return *buffers;
+}
+
+int ConnectionPool::get_live_count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return live_connections;
+}
+
 void ConnectionPool::shutdown() {
     UtilityFunctions::print("Shutting down connection pool.");
+    std::lock_guard<std::mutex> lock(mutex);
     shutting_down = true;
     condition.notify_all();
-    std::lock_guard<std::mutex> lock(mutex);
     while (!connections.empty()) {
         pqxx::connection* conn = connections.front();
         connections.pop();
         if (conn) {
             UtilityFunctions::print("Deleting connection.");
+            scratch_buffers.erase(conn);
             delete conn;
         }
     }
@@ -6,6 +6,10 @@
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <memory>
+#include <atomic>
+#include <unordered_map>
+#include "query_scratch.h"
 
 namespace godot {
 
@@ -17,13 +21,32 @@ private:
     std::mutex mutex;
     std::condition_variable condition;
     bool shutting_down = false;
+    // Connections owned by the pool, idle or checked out
+    int live_connections = 0;
+    // Log every acquire and release
+    std::atomic<bool> verbose{ false };
+    // Per-connection scratch buffers, created on first use
+    std::unordered_map<pqxx::connection*, std::unique_ptr<QueryScratch>> scratch_buffers;
 
 public:
     ConnectionPool(const String& p_connection_string, int p_pool_size);
     ~ConnectionPool();
 
-    pqxx::connection* acquire();
+    // Waits up to p_timeout_msec for an idle connection. Returns nullptr on
+    // timeout, during shutdown, or right away once the pool has no live
+    // connections left to wait for.
+    pqxx::connection* acquire(int p_timeout_msec);
+    // Returns an idle connection, or nullptr right away if none is free
+    pqxx::connection* try_acquire();
     void release(pqxx::connection* connection);
+    // Drops a broken connection and tries to open a replacement so the pool
+    // does not shrink every time the server drops a socket.
+    void discard(pqxx::connection* connection);
+    // Scratch buffers owned by a checked-out connection. Only the thread
+    // holding the connection may use them.
+    QueryScratch& scratch(pqxx::connection* connection);
+    int get_live_count();
+    void set_verbose(bool p_verbose) { verbose.store(p_verbose, std::memory_order_relaxed); }
 
     void shutdown();
 };
@@ -0,0 +1,91 @@
+#include "object_mapping.h"
+#include <godot_cpp/classes/global_constants.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+namespace godot {
+
+std::shared_ptr<ObjectMapping> ObjectMapping::compile(Object* p_prototype, const pqxx::result& p_result) {
+    std::shared_ptr<ObjectMapping> mapping = std::make_shared<ObjectMapping>();
+
+    // Index the target's properties once; group and category entries are
+    // inspector headings, not real properties.
+    const uint32_t not_a_property = PROPERTY_USAGE_CATEGORY | PROPERTY_USAGE_GROUP | PROPERTY_USAGE_SUBGROUP;
+    std::unordered_map<std::string, Variant::Type> properties;
+    Array property_list = p_prototype->get_property_list();
+    for (int64_t i = 0; i < property_list.size(); ++i) {
+        Dictionary info = property_list[i];
+        if ((uint32_t)(int64_t)info["usage"] & not_a_property) {
+            continue;
+        }
+        CharString name = String(info["name"]).utf8();
+        properties[std::string(name.get_data(), name.length())] = (Variant::Type)(int)info["type"];
+    }
+
+    int column_count = (int)p_result.columns();
+    mapping->columns.reserve(column_count);
+    for (int c = 0; c < column_count; ++c) {
+        const char* column = p_result.column_name(c);
+        mapping->columns.emplace_back(column);
+        auto it = properties.find(column);
+        if (it == properties.end()) {
+            UtilityFunctions::print("Column '", column, "' has no matching property on ", p_prototype->get_class(), ", skipping it.");
+            continue;
+        }
+        mapping->bindings.push_back({ c, StringName(String::utf8(column)), it->second });
+    }
+    return mapping;
+}
+
+bool ObjectMapping::matches(const pqxx::result& p_result) const {
+    if ((size_t)p_result.columns() != columns.size()) {
+        return false;
+    }
+    for (size_t c = 0; c < columns.size(); ++c) {
+        if (columns[c] != p_result.column_name((pqxx::row::size_type)c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Variant ObjectMapping::convert_field(const pqxx::field& p_field, Variant::Type p_type) {
+    const char* text = p_field.c_str();
+    size_t length = p_field.size();
+    switch (p_type) {
+        case Variant::INT: {
+            int64_t value = 0;
+            std::from_chars(text, text + length, value);
+            return value;
+        }
+        case Variant::FLOAT:
+            return std::strtod(text, nullptr);
+        case Variant::BOOL:
+            // PostgreSQL sends booleans as 't' / 'f'
+            return length > 0 && (text[0] == 't' || text[0] == 'T' || text[0] == '1');
+        case Variant::STRING_NAME:
+            return StringName(String::utf8(text, (int64_t)length));
+        default:
+            // Strings, untyped properties and anything without a direct text
+            // form are handed over as text and left to Object::set().
+            return String::utf8(text, (int64_t)length);
+    }
+}
+
+void ObjectMapping::apply(const pqxx::row& p_row, Object* p_target) const {
+    for (const Binding& binding : bindings) {
+        pqxx::field field = p_row[binding.column];
+        if (field.is_null()) {
+            // Keep the property's default rather than assigning null to a typed property
+            continue;
+        }
+        p_target->set(binding.property, convert_field(field, binding.type));
+    }
+}
+
+}
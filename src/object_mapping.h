@@ -0,0 +1,46 @@
+#ifndef OBJECT_MAPPING_H
+#define OBJECT_MAPPING_H
+
+#include <godot_cpp/core/object.hpp>
+#include <godot_cpp/variant/string_name.hpp>
+#include <godot_cpp/variant/variant.hpp>
+#include <pqxx/pqxx>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace godot {
+
+// Column-to-property binding for one (query, class) pair. Compiled once from
+// the first result and a prototype instance, then reused to fill objects
+// straight from the pqxx rows with values already converted to each
+// property's type, without building an intermediate Dictionary. The
+// property list is only read when compiling; each cell is still assigned
+// through Object::set(), which looks the property up by name. godot-cpp
+// exposes no setter handle that works for both engine and script properties.
+class ObjectMapping {
+private:
+    struct Binding {
+        int column;
+        StringName property;
+        Variant::Type type;
+    };
+
+    std::vector<std::string> columns;
+    std::vector<Binding> bindings;
+
+    static Variant convert_field(const pqxx::field& p_field, Variant::Type p_type);
+
+public:
+    static std::shared_ptr<ObjectMapping> compile(Object* p_prototype, const pqxx::result& p_result);
+
+    // True if p_result has the columns this mapping was compiled for
+    bool matches(const pqxx::result& p_result) const;
+    int get_bound_count() const { return (int)bindings.size(); }
+
+    void apply(const pqxx::row& p_row, Object* p_target) const;
+};
+
+}
+
+#endif
@@ -1,12 +1,43 @@
 #include <godot_cpp/variant/string.hpp>
 #include "postgreadapter.h"
 #include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/memory.hpp>
+#include <godot_cpp/classes/class_db_singleton.hpp>
+#include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/classes/scene_tree.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
 #include <pqxx/pqxx> // For PostgreSQL interaction
+#include <cmath>
 #include "connection_pool.h"
+#include "query_scratch.h"
+#include "query_tracer.h"
 
 using namespace godot;
 
+static uint64_t ticks_usec() {
+	return Time::get_singleton()->get_ticks_usec();
+}
+
+// Acquires a connection and adds the time spent waiting for it to r_wait_usec.
+static pqxx::connection *acquire_timed(ConnectionPool &p_pool, int p_timeout_msec, uint64_t &r_wait_usec) {
+	uint64_t wait_start = ticks_usec();
+	pqxx::connection *conn = p_pool.acquire(p_timeout_msec);
+	r_wait_usec += ticks_usec() - wait_start;
+	return conn;
+}
+
+// Runs the statement whose text and parameters are already encoded in p_scratch.
+// The traced span covers the server round trip including fetching the rows.
+static pqxx::result exec_encoded(pqxx::transaction_base &p_tx, const QueryScratch &p_scratch, pqxx::zview p_query, uint32_t p_query_hash) {
+	TraceSpan span("execute", p_query_hash);
+	pqxx::result result = p_scratch.get_param_count() > 0 ? p_tx.exec_params(p_query, p_scratch.build_params()) : p_tx.exec(p_query);
+	span.set_rows((int64_t)result.size());
+	return result;
+}
+
 void PostgreAdapter::_bind_methods() {
  	ClassDB::bind_method(D_METHOD("set_connection_string", "connection_string"), &PostgreAdapter::set_connection_string);
  	ClassDB::bind_method(D_METHOD("get_connection_string"), &PostgreAdapter::get_connection_string);
@@ -15,13 +46,70 @@ void PostgreAdapter::_bind_methods() {
  	ClassDB::bind_method(D_METHOD("set_pool_size", "pool_size"), &PostgreAdapter::set_pool_size);
  	ClassDB::bind_method(D_METHOD("get_pool_size"), &PostgreAdapter::get_pool_size);
  	ADD_PROPERTY(PropertyInfo(Variant::INT, "pool_size"), "set_pool_size", "get_pool_size");
+
+	ClassDB::bind_method(D_METHOD("set_acquire_timeout_ms", "timeout_ms"), &PostgreAdapter::set_acquire_timeout_ms);
+	ClassDB::bind_method(D_METHOD("get_acquire_timeout_ms"), &PostgreAdapter::get_acquire_timeout_ms);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "acquire_timeout_ms"), "set_acquire_timeout_ms", "get_acquire_timeout_ms");
+
+	ClassDB::bind_method(D_METHOD("set_verbose_logging", "enabled"), &PostgreAdapter::set_verbose_logging);
+	ClassDB::bind_method(D_METHOD("get_verbose_logging"), &PostgreAdapter::get_verbose_logging);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "verbose_logging"), "set_verbose_logging", "get_verbose_logging");
+
+	ClassDB::bind_method(D_METHOD("set_dispatch_budget_usec", "usec"), &PostgreAdapter::set_dispatch_budget_usec);
+	ClassDB::bind_method(D_METHOD("get_dispatch_budget_usec"), &PostgreAdapter::get_dispatch_budget_usec);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "dispatch_budget_usec"), "set_dispatch_budget_usec", "get_dispatch_budget_usec");
+
+	ClassDB::bind_method(D_METHOD("get_scratch_growth_count"), &PostgreAdapter::get_scratch_growth_count);
+
+	ClassDB::bind_method(D_METHOD("set_coalesce_reads", "enabled"), &PostgreAdapter::set_coalesce_reads);
+	ClassDB::bind_method(D_METHOD("get_coalesce_reads"), &PostgreAdapter::get_coalesce_reads);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "coalesce_reads"), "set_coalesce_reads", "get_coalesce_reads");
+
+	// Slow-query log
+	ClassDB::bind_method(D_METHOD("set_slow_query_threshold_ms", "threshold_ms"), &PostgreAdapter::set_slow_query_threshold_ms);
+	ClassDB::bind_method(D_METHOD("get_slow_query_threshold_ms"), &PostgreAdapter::get_slow_query_threshold_ms);
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "slow_query_threshold_ms"), "set_slow_query_threshold_ms", "get_slow_query_threshold_ms");
+	ClassDB::bind_method(D_METHOD("set_slow_query_log_size", "size"), &PostgreAdapter::set_slow_query_log_size);
+	ClassDB::bind_method(D_METHOD("get_slow_query_log_size"), &PostgreAdapter::get_slow_query_log_size);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "slow_query_log_size"), "set_slow_query_log_size", "get_slow_query_log_size");
+	ClassDB::bind_method(D_METHOD("set_capture_explain", "enabled"), &PostgreAdapter::set_capture_explain);
+	ClassDB::bind_method(D_METHOD("get_capture_explain"), &PostgreAdapter::get_capture_explain);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "capture_explain"), "set_capture_explain", "get_capture_explain");
+	ClassDB::bind_method(D_METHOD("get_slow_queries"), &PostgreAdapter::get_slow_queries);
+	ClassDB::bind_method(D_METHOD("clear_slow_queries"), &PostgreAdapter::clear_slow_queries);
+
+	// Workload recording
+	ClassDB::bind_method(D_METHOD("start_recording", "path"), &PostgreAdapter::start_recording);
+	ClassDB::bind_method(D_METHOD("stop_recording"), &PostgreAdapter::stop_recording);
+	ClassDB::bind_method(D_METHOD("is_recording"), &PostgreAdapter::is_recording);
+
+	// Tracing
+	ClassDB::bind_method(D_METHOD("start_trace", "path"), &PostgreAdapter::start_trace);
+	ClassDB::bind_method(D_METHOD("stop_trace"), &PostgreAdapter::stop_trace);
+	ClassDB::bind_method(D_METHOD("is_tracing"), &PostgreAdapter::is_tracing);
+
+	ClassDB::bind_method(D_METHOD("set_result_chunk_size", "rows"), &PostgreAdapter::set_result_chunk_size);
+	ClassDB::bind_method(D_METHOD("get_result_chunk_size"), &PostgreAdapter::get_result_chunk_size);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "result_chunk_size"), "set_result_chunk_size", "get_result_chunk_size");
+ 
+	ClassDB::bind_method(D_METHOD("set_shard_connection_strings", "connection_strings"), &PostgreAdapter::set_shard_connection_strings);
+	ClassDB::bind_method(D_METHOD("get_shard_connection_strings"), &PostgreAdapter::get_shard_connection_strings);
+	ADD_PROPERTY(PropertyInfo(Variant::PACKED_STRING_ARRAY, "shard_connection_strings"), "set_shard_connection_strings", "get_shard_connection_strings");
  
  	ClassDB::bind_method(D_METHOD("connect_to_db"), &PostgreAdapter::connect_to_db);
  	ClassDB::bind_method(D_METHOD("disconnect_from_db"), &PostgreAdapter::disconnect_from_db);
  	ClassDB::bind_method(D_METHOD("execute_query", "query", "params"), &PostgreAdapter::execute_query, DEFVAL(Array()));
  	ClassDB::bind_method(D_METHOD("execute_non_query", "query", "params"), &PostgreAdapter::execute_non_query, DEFVAL(Array()));
+ 	ClassDB::bind_method(D_METHOD("execute_query_into", "class_or_script", "query", "params"), &PostgreAdapter::execute_query_into, DEFVAL(Array()));
  	ClassDB::bind_method(D_METHOD("_to_string"), &PostgreAdapter::_to_string);
  	
+ 	// Sharding methods
+ 	ClassDB::bind_method(D_METHOD("get_shard_count"), &PostgreAdapter::get_shard_count);
+ 	ClassDB::bind_method(D_METHOD("get_shard_for_key", "key"), &PostgreAdapter::get_shard_for_key);
+ 	ClassDB::bind_method(D_METHOD("execute_query_sharded", "key", "query", "params"), &PostgreAdapter::execute_query_sharded, DEFVAL(Array()));
+ 	ClassDB::bind_method(D_METHOD("execute_non_query_sharded", "key", "query", "params"), &PostgreAdapter::execute_non_query_sharded, DEFVAL(Array()));
+ 	ClassDB::bind_method(D_METHOD("execute_query_all_shards", "query", "params"), &PostgreAdapter::execute_query_all_shards, DEFVAL(Array()));
+ 	
  	// Transaction methods
  	ClassDB::bind_method(D_METHOD("begin_transaction"), &PostgreAdapter::begin_transaction);
  	ClassDB::bind_method(D_METHOD("commit_transaction"), &PostgreAdapter::commit_transaction);
@@ -30,8 +118,8 @@ void PostgreAdapter::_bind_methods() {
  	ClassDB::bind_method(D_METHOD("execute_non_query_in_transaction", "query", "params"), &PostgreAdapter::execute_non_query_in_transaction, DEFVAL(Array()));
  	
  	// Async methods
- 	ClassDB::bind_method(D_METHOD("execute_query_async", "query", "params"), &PostgreAdapter::execute_query_async, DEFVAL(Array()));
- 	ClassDB::bind_method(D_METHOD("execute_non_query_async", "query", "params"), &PostgreAdapter::execute_non_query_async, DEFVAL(Array()));
+ 	ClassDB::bind_method(D_METHOD("execute_query_async", "query", "params", "priority"), &PostgreAdapter::execute_query_async, DEFVAL(Array()), DEFVAL(0));
+ 	ClassDB::bind_method(D_METHOD("execute_non_query_async", "query", "params", "priority"), &PostgreAdapter::execute_non_query_async, DEFVAL(Array()), DEFVAL(0));
 
 	// Bind signals
 	ADD_SIGNAL(MethodInfo("query_failed", PropertyInfo(Variant::STRING, "query"), PropertyInfo(Variant::STRING, "error_message")));
@@ -42,12 +130,20 @@ void PostgreAdapter::_bind_methods() {
 	ADD_SIGNAL(MethodInfo("query_completed", PropertyInfo(Variant::ARRAY, "results")));
 	ADD_SIGNAL(MethodInfo("non_query_completed", PropertyInfo(Variant::INT, "affected_rows")));
 	ADD_SIGNAL(MethodInfo("async_query_failed", PropertyInfo(Variant::STRING, "query"), PropertyInfo(Variant::STRING, "error_message")));
+	// Same events carrying the id returned by execute_*_async
+	ADD_SIGNAL(MethodInfo("query_request_completed", PropertyInfo(Variant::INT, "request_id"), PropertyInfo(Variant::ARRAY, "results")));
+	ADD_SIGNAL(MethodInfo("query_chunk_received", PropertyInfo(Variant::INT, "request_id"), PropertyInfo(Variant::ARRAY, "rows"), PropertyInfo(Variant::BOOL, "is_last")));
+	ADD_SIGNAL(MethodInfo("non_query_request_completed", PropertyInfo(Variant::INT, "request_id"), PropertyInfo(Variant::INT, "affected_rows")));
+	ADD_SIGNAL(MethodInfo("async_request_failed", PropertyInfo(Variant::INT, "request_id"), PropertyInfo(Variant::STRING, "query"), PropertyInfo(Variant::STRING, "error_message")));
 	
 	// Transaction signals
 	ADD_SIGNAL(MethodInfo("transaction_started"));
 	ADD_SIGNAL(MethodInfo("transaction_committed"));
 	ADD_SIGNAL(MethodInfo("transaction_rolled_back"));
 	ADD_SIGNAL(MethodInfo("transaction_failed", PropertyInfo(Variant::STRING, "error_message")));
+	
+	// Slow-query signal
+	ADD_SIGNAL(MethodInfo("slow_query", PropertyInfo(Variant::DICTIONARY, "entry")));
 }
  
 PostgreAdapter::PostgreAdapter() :
@@ -63,15 +159,31 @@ void PostgreAdapter::_notification(int p_what) {
 			// This is called after the object is created and initialized.
 			// Good place for one-time setup that doesn't depend on being in the scene tree.
 		} break;
+		case NOTIFICATION_ENTER_TREE: {
+			// Async results are handed out from the internal process step
+			set_process_internal(true);
+		} break;
+		case NOTIFICATION_INTERNAL_PROCESS: {
+			dispatcher.drain(this, dispatch_budget_usec, result_chunk_size);
+			QueryTracer::flush_if_due();
+		} break;
 		case NOTIFICATION_PREDELETE: {
-			// This is called before the object is deleted.
-			// Good place for cleanup that needs to happen before destruction.
+			// Worker tasks hold a raw pointer to this node; let them finish
+			// while the object is still fully alive.
+			_wait_for_pending_tasks();
+			workers.stop();
+			dispatcher.clear();
+			if (owns_trace) {
+				stop_trace();
+			}
+			recorder.stop();
 		} break;
 	}
 }
 
 PostgreAdapter::~PostgreAdapter() {
 	// Clean up any active transaction
+	std::lock_guard<std::recursive_mutex> tx_lock(transaction_mutex);
 	if (current_transaction) {
 		try {
 			current_transaction->abort();
@@ -83,21 +195,21 @@ PostgreAdapter::~PostgreAdapter() {
 	}
 	
 	if (transaction_connection) {
-		if (connection_pool) {
-			connection_pool->release(transaction_connection);
+		if (transaction_pool) {
+			transaction_pool->release(transaction_connection);
 		}
 		transaction_connection = nullptr;
 	}
+	transaction_pool.reset();
 	
-	if (connection_pool) {
-		delete connection_pool;
-		connection_pool = nullptr;
-	}
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	connection_pool.reset();
+	shard_pools.clear();
 }
 
 void PostgreAdapter::_ready() {
 	// Optional: Connect to DB on _ready if connection_string is already set
-	if (!connection_string.is_empty()) {
+	if (!get_connection_string().is_empty()) {
 		connect_to_db();
 	}
 }
@@ -107,273 +219,625 @@ void PostgreAdapter::_exit_tree() {
 }
 
 void PostgreAdapter::set_connection_string(const String &p_connection_string) {
-	connection_string = p_connection_string;
-	if (connection_pool) {
-		delete connection_pool;
-		connection_pool = nullptr;
+	std::shared_ptr<ConnectionPool> new_pool;
+	int size;
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		connection_string = p_connection_string;
+		size = pool_size;
 	}
-	// Create new connection pool with updated connection string
-	if (!connection_string.is_empty()) {
-		connection_pool = new ConnectionPool(connection_string, pool_size);
+	// Create new connection pool with updated connection string. Connecting
+	// can take a while, so it happens outside the lock.
+	if (!p_connection_string.is_empty()) {
+		new_pool = _create_pool(p_connection_string, size);
 	}
+	// The old pool is destroyed once the last in-flight query drops it.
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	connection_pool = new_pool;
 }
 
 String PostgreAdapter::get_connection_string() const {
- 	return connection_string;
- }
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	return connection_string;
+}
  
 void PostgreAdapter::set_pool_size(int p_pool_size) {
 	if (p_pool_size > 0) {
-		pool_size = p_pool_size;
-		if (connection_pool) {
+		String conn_str;
+		PackedStringArray shard_strs;
+		bool has_pool;
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			pool_size = p_pool_size;
+			conn_str = connection_string;
+			shard_strs = shard_connection_strings;
+			has_pool = connection_pool != nullptr;
+		}
+		if (has_pool) {
 			// Re-initialize pool with new size if already connected
-			delete connection_pool;
-			connection_pool = new ConnectionPool(connection_string, pool_size);
+			std::shared_ptr<ConnectionPool> new_pool = _create_pool(conn_str, p_pool_size);
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			connection_pool = new_pool;
+		}
+		if (!shard_strs.is_empty()) {
+			_rebuild_shard_pools(shard_strs, p_pool_size);
 		}
+		_update_worker_count();
 	} else {
 		UtilityFunctions::print("Pool size must be greater than 0.");
 	}
 }
  
 int PostgreAdapter::get_pool_size() const {
+	std::lock_guard<std::mutex> lock(pool_mutex);
 	return pool_size;
 }
 
+void PostgreAdapter::set_acquire_timeout_ms(int p_timeout_ms) {
+	acquire_timeout_ms.store(p_timeout_ms > 0 ? p_timeout_ms : 0);
+}
+
+int PostgreAdapter::get_acquire_timeout_ms() const {
+	return acquire_timeout_ms.load();
+}
+
+void PostgreAdapter::set_verbose_logging(bool p_enabled) {
+	verbose_logging.store(p_enabled);
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	if (connection_pool) {
+		connection_pool->set_verbose(p_enabled);
+	}
+	for (const std::shared_ptr<ConnectionPool> &shard_pool : shard_pools) {
+		shard_pool->set_verbose(p_enabled);
+	}
+}
+
+bool PostgreAdapter::get_verbose_logging() const {
+	return verbose_logging.load();
+}
+
+void PostgreAdapter::set_dispatch_budget_usec(int p_usec) {
+	dispatch_budget_usec = p_usec > 0 ? p_usec : 0;
+}
+
+int PostgreAdapter::get_dispatch_budget_usec() const {
+	return dispatch_budget_usec;
+}
+
+void PostgreAdapter::set_result_chunk_size(int p_rows) {
+	result_chunk_size = p_rows > 0 ? p_rows : 0;
+}
+
+int PostgreAdapter::get_result_chunk_size() const {
+	return result_chunk_size;
+}
+
+void PostgreAdapter::set_coalesce_reads(bool p_enabled) {
+	coalesce_reads.store(p_enabled);
+}
+
+bool PostgreAdapter::get_coalesce_reads() const {
+	return coalesce_reads.load();
+}
+
+int64_t PostgreAdapter::get_scratch_growth_count() const {
+	return (int64_t)QueryScratch::get_growth_count();
+}
+
+// Slow-query log. Statements slower than the threshold are logged with their
+// timing; with capture_explain their plan is fetched first on a spare
+// connection from a worker task, so the caller never waits for it.
+void PostgreAdapter::set_slow_query_threshold_ms(double p_threshold_ms) {
+	slow_query_threshold_ms.store(p_threshold_ms > 0.0 ? p_threshold_ms : 0.0);
+}
+
+double PostgreAdapter::get_slow_query_threshold_ms() const {
+	return slow_query_threshold_ms.load();
+}
+
+void PostgreAdapter::set_slow_query_log_size(int p_size) {
+	slow_queries.set_capacity(p_size);
+}
+
+int PostgreAdapter::get_slow_query_log_size() const {
+	return slow_queries.get_capacity();
+}
+
+void PostgreAdapter::set_capture_explain(bool p_enabled) {
+	capture_explain.store(p_enabled);
+}
+
+bool PostgreAdapter::get_capture_explain() const {
+	return capture_explain.load();
+}
+
+Array PostgreAdapter::get_slow_queries() {
+	return slow_queries.get_entries();
+}
+
+void PostgreAdapter::clear_slow_queries() {
+	slow_queries.clear();
+}
+
+void PostgreAdapter::_note_query_timing(const std::shared_ptr<ConnectionPool> &p_pool, const String &p_query, const Array &p_params, uint64_t p_duration_usec, uint64_t p_wait_usec, int64_t p_rows) {
+	double threshold_ms = slow_query_threshold_ms.load(std::memory_order_relaxed);
+	if (threshold_ms <= 0.0 || p_duration_usec < (uint64_t)(threshold_ms * 1000.0)) {
+		return;
+	}
+
+	Dictionary entry;
+	entry["query"] = p_query;
+	entry["params_hash"] = (int64_t)p_params.hash();
+	entry["duration_ms"] = p_duration_usec / 1000.0;
+	entry["pool_wait_ms"] = p_wait_usec / 1000.0;
+	entry["rows"] = p_rows;
+	entry["timestamp"] = Time::get_singleton()->get_unix_time_from_system();
+	entry["explain"] = String();
+
+	if (capture_explain.load(std::memory_order_relaxed) && p_pool) {
+		{
+			std::lock_guard<std::mutex> lock(explain_mutex);
+			explain_jobs.push_back({ p_pool, entry, p_params.duplicate() });
+		}
+		_submit_task(callable_mp(this, &PostgreAdapter::_run_explain_jobs));
+		return;
+	}
+	_publish_slow_query(entry);
+}
+
+void PostgreAdapter::_run_explain_jobs() {
+	while (true) {
+		ExplainJob job;
+		{
+			std::lock_guard<std::mutex> lock(explain_mutex);
+			if (explain_jobs.empty()) {
+				return;
+			}
+			job = explain_jobs.front();
+			explain_jobs.pop_front();
+		}
+
+		// Only use an idle connection; never queue behind real traffic for a plan
+		pqxx::connection *conn = job.pool->try_acquire();
+		if (!conn) {
+			job.entry["explain_error"] = "No spare connection";
+		} else {
+			try {
+				QueryScratch &scratch = job.pool->scratch(conn);
+				pqxx::zview explain_text = scratch.encode_query(String("EXPLAIN (FORMAT JSON) ") + String(job.entry["query"]));
+				String error;
+				if (!scratch.encode_params(job.params, error)) {
+					job.entry["explain_error"] = error;
+				} else {
+					// EXPLAIN without ANALYZE plans the statement without running it
+					pqxx::read_transaction tx(*conn);
+					pqxx::result plan = exec_encoded(tx, scratch, explain_text, 0);
+					if (!plan.empty()) {
+						pqxx::field field = plan[0][0];
+						job.entry["explain"] = String::utf8(field.c_str(), (int64_t)field.size());
+					}
+				}
+				job.pool->release(conn);
+			} catch (const pqxx::broken_connection &e) {
+				job.pool->discard(conn);
+				job.entry["explain_error"] = String(e.what());
+			} catch (const std::exception &e) {
+				job.pool->release(conn);
+				job.entry["explain_error"] = String(e.what());
+			}
+		}
+		_publish_slow_query(job.entry);
+	}
+}
+
+void PostgreAdapter::_publish_slow_query(const Dictionary &p_entry) {
+	UtilityFunctions::print("Slow query (", p_entry["duration_ms"], " ms): ", p_entry["query"]);
+	slow_queries.add(p_entry);
+	emit_signal_threadsafe("slow_query", p_entry);
+}
+
+// Workload recording for offline replay with tools/workload_replay
+bool PostgreAdapter::start_recording(const String &p_path) {
+	return recorder.start(p_path);
+}
+
+bool PostgreAdapter::stop_recording() {
+	return recorder.stop();
+}
+
+bool PostgreAdapter::is_recording() const {
+	return recorder.is_recording();
+}
+
+// Tracing is process-wide: spans from every adapter and thread go into the
+// same file. The adapter that started it flushes it from its process step.
+bool PostgreAdapter::start_trace(const String &p_path) {
+	owns_trace = QueryTracer::start(p_path);
+	return owns_trace;
+}
+
+bool PostgreAdapter::stop_trace() {
+	owns_trace = false;
+	return QueryTracer::stop();
+}
+
+bool PostgreAdapter::is_tracing() const {
+	return QueryTracer::is_enabled();
+}
+
+std::shared_ptr<ConnectionPool> PostgreAdapter::get_pool() const {
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	return connection_pool;
+}
+
+std::shared_ptr<ConnectionPool> PostgreAdapter::_create_pool(const String &p_connection_string, int p_pool_size) const {
+	std::shared_ptr<ConnectionPool> pool = std::make_shared<ConnectionPool>(p_connection_string, p_pool_size);
+	pool->set_verbose(verbose_logging.load());
+	return pool;
+}
+
 bool PostgreAdapter::connect_to_db() {
-	if (!connection_pool) {
+	std::shared_ptr<ConnectionPool> pool = get_pool();
+	if (!pool && get_shard_count() == 0) {
 		UtilityFunctions::print("Connection pool is not initialized. Set connection_string first.");
 		return false;
 	}
+	if (pool && pool->get_live_count() == 0) {
+		UtilityFunctions::print("Connection pool has no open connections. Check connection_string and the server.");
+		emit_signal_threadsafe("connection_error", "No open connections in pool");
+		return false;
+	}
 	
 	UtilityFunctions::print("Connection pool is available with connections.");
 	return true;
 }
 
 void PostgreAdapter::disconnect_from_db() {
-	if (connection_pool) {
+	std::shared_ptr<ConnectionPool> old_pool;
+	std::vector<std::shared_ptr<ConnectionPool>> old_shards;
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		old_pool.swap(connection_pool);
+		old_shards.swap(shard_pools);
+	}
+	if (old_pool || !old_shards.empty()) {
+		// Queries still running on other threads keep the pool alive until they finish.
 		UtilityFunctions::print("Shutting down connection pool.");
-		delete connection_pool;
-		connection_pool = nullptr;
 	} else {
 		UtilityFunctions::print("No connection pool to disconnect.");
 	}
 }
 
 Array PostgreAdapter::execute_query(const String &p_query, const Array& p_params /*= Array()*/) {
+    recorder.record(workload::API_QUERY, p_query, p_params);
     Array result_array;
-    UtilityFunctions::print("execute_query called with query: ", p_query);
+    String error;
+    std::shared_ptr<ConnectionPool> pool = get_pool();
+    if (!pool) {
+        UtilityFunctions::print("Connection pool is not initialized. Set connection_string first.");
+        emit_signal_threadsafe("connection_error", "Connection pool not initialized");
+        return result_array;
+    }
+    _execute_read(pool, p_query, p_params, result_array, error);
+    return result_array;
+}
+
+// Creates one instance of the target given to execute_query_into: a class
+// name goes through ClassDB, a Script through its new() method.
+static Variant instantiate_target(const Variant &p_class_or_script) {
+	if (p_class_or_script.get_type() == Variant::STRING || p_class_or_script.get_type() == Variant::STRING_NAME) {
+		return ClassDBSingleton::get_singleton()->instantiate(p_class_or_script);
+	}
+	Object *script = p_class_or_script;
+	if (script && script->has_method("new")) {
+		return script->call("new");
+	}
+	return Variant();
+}
+
+// Drops the rows of a failed execute_query_into. RefCounted rows go away with
+// the Array; anything else (a Node, a plain Object) has to be freed by hand.
+static void free_instances(Array &r_rows) {
+	for (int64_t i = 0; i < r_rows.size(); ++i) {
+		Object *object = r_rows[i];
+		if (object && !Object::cast_to<RefCounted>(object)) {
+			memdelete(object);
+		}
+	}
+	r_rows.clear();
+}
+
+Array PostgreAdapter::execute_query_into(const Variant &p_class_or_script, const String &p_query, const Array& p_params) {
+	recorder.record(workload::API_QUERY, p_query, p_params);
+	Array result_array;
+
+	String target_key;
+	if (p_class_or_script.get_type() == Variant::STRING || p_class_or_script.get_type() == Variant::STRING_NAME) {
+		target_key = String("class:") + String(p_class_or_script);
+	} else if (Object *script = p_class_or_script) {
+		target_key = String("script:") + String::num_uint64(script->get_instance_id());
+	} else {
+		UtilityFunctions::print("execute_query_into expects a class name or a Script.");
+		emit_signal_threadsafe("query_failed", p_query, "Invalid class_or_script");
+		return result_array;
+	}
+
+	std::shared_ptr<ConnectionPool> pool = get_pool();
+	if (!pool) {
+		UtilityFunctions::print("Connection pool is not initialized. Set connection_string first.");
+		emit_signal_threadsafe("connection_error", "Connection pool not initialized");
+		return result_array;
+	}
+
+	CharString key_utf8 = (target_key + "\n" + p_query).utf8();
+	std::string mapping_key(key_utf8.get_data(), key_utf8.length());
+
+	ResultConverter converter = [&](const pqxx::result &R, Array &r_rows, String &r_error) -> bool {
+		std::shared_ptr<ObjectMapping> mapping;
+		{
+			std::lock_guard<std::mutex> lock(mapping_mutex);
+			auto it = object_mappings.find(mapping_key);
+			if (it != object_mappings.end() && it->second->matches(R)) {
+				mapping = it->second;
+			}
+		}
+
+		r_rows.resize((int64_t)R.size());
+		int64_t index = 0;
+		for (pqxx::row const &row : R) {
+			Variant instance = instantiate_target(p_class_or_script);
+			Object *object = instance;
+			if (!object) {
+				// The caller frees the rows created so far
+				r_error = String("Could not instantiate ") + target_key;
+				return false;
+			}
+			if (!mapping) {
+				// First use of this (query, class) pair, or its columns changed
+				mapping = ObjectMapping::compile(object, R);
+				std::lock_guard<std::mutex> lock(mapping_mutex);
+				object_mappings[mapping_key] = mapping;
+			}
+			mapping->apply(row, object);
+			r_rows[index++] = instance;
+		}
+		return true;
+	};
+
+	String error;
+	if (!_execute_query(pool, p_query, p_params, result_array, error, converter)) {
+		free_instances(result_array);
+		emit_signal_threadsafe("query_failed", p_query, error);
+	}
+	return result_array;
+}
+
+// With coalesce_reads on, identical reads (same pool, SQL and parameters)
+// that overlap in time share one round trip and one result Array. Only
+// plain SELECT/WITH reads qualify; INSERT ... RETURNING or nextval() must
+// run once per caller.
+bool PostgreAdapter::_execute_read(const std::shared_ptr<ConnectionPool> &p_pool, const String &p_query, const Array &p_params, Array &r_result, String &r_error) {
+    if (!coalesce_reads.load(std::memory_order_relaxed) || !SingleFlight::is_plain_read(p_query)) {
+        return _execute_query(p_pool, p_query, p_params, r_result, r_error);
+    }
+
+    // var_to_str keeps parameter types apart, so 1, 1.0 and "1" never collide
+    String key = String::num_uint64((uint64_t)(uintptr_t)p_pool.get(), 16) + "\n" + p_query + "\n" + UtilityFunctions::var_to_str(p_params);
+    CharString key_utf8 = key.utf8();
+    std::string flight_key(key_utf8.get_data(), key_utf8.length());
+
+    bool leader = false;
+    std::shared_ptr<SingleFlight::Call> call = in_flight_reads.join(flight_key, leader);
+    if (leader) {
+        bool ok = _execute_query(p_pool, p_query, p_params, r_result, r_error);
+        in_flight_reads.finish(flight_key, call, ok, r_result, r_error);
+        return ok;
+    }
+
+    _log_verbose("Attaching to identical in-flight query: ", p_query);
+    SingleFlight::wait(*call);
+    r_result = call->result;
+    r_error = call->error;
+    return call->ok;
+}
+
+bool PostgreAdapter::_execute_query(const std::shared_ptr<ConnectionPool> &p_pool, const String &p_query, const Array &p_params, Array &r_result, String &r_error, const ResultConverter &p_converter) {
+    Array &result_array = r_result;
+    _log_verbose("execute_query called with query: ", p_query);
     if (!p_params.is_empty()) {
-        UtilityFunctions::print("execute_query called with params: ", p_params);
+        _log_verbose("execute_query called with params: ", p_params);
     }
 
-    pqxx::connection* conn = connection_pool->acquire();
+    uint64_t started_usec = ticks_usec();
+    uint64_t wait_usec = 0;
+    uint32_t trace_hash = QueryTracer::query_hash(p_query);
+    pqxx::connection* conn = acquire_timed(*p_pool, acquire_timeout_ms.load(std::memory_order_relaxed), wait_usec);
     if (!conn) {
         UtilityFunctions::print("Failed to acquire connection from pool.");
-        return result_array;
+        r_error = "Failed to acquire connection from pool";
+        return false;
     }
 
     for (int retries = 0; retries < 2; ++retries) { // Allow one retry
-        UtilityFunctions::print("Attempting query, retry #", retries);
+        _log_verbose("Attempting query, retry #", retries);
         if (!conn || !conn->is_open()) {
             UtilityFunctions::print("Connection not open for query, will need new connection.");
-            // Return this connection to pool and get a new one
+            // Replace the dead connection and get a new one
             if (conn) {
-                connection_pool->release(conn);
+                p_pool->discard(conn);
             }
-            conn = connection_pool->acquire();
+            conn = acquire_timed(*p_pool, acquire_timeout_ms.load(std::memory_order_relaxed), wait_usec);
             if (!conn) {
                 UtilityFunctions::print("Failed to acquire new connection from pool.");
-                return result_array;
+                r_error = "Failed to acquire connection from pool";
+                return false;
             }
         }
 
         // Ensure connection is valid before proceeding with transaction/query
-        ERR_FAIL_COND_V_MSG(!conn->is_open(), result_array, "PostgreSQL connection is not valid or open before executing query.");
+        if (!conn->is_open()) {
+            p_pool->release(conn);
+            r_error = "PostgreSQL connection is not valid or open";
+            ERR_FAIL_V_MSG(false, "PostgreSQL connection is not valid or open before executing query.");
+        }
 
         try {
-            UtilityFunctions::print("Creating pqxx::work object for query...");
-            pqxx::work W(*conn);
-            UtilityFunctions::print("Executing query: ", p_query);
-
-            pqxx::result R;
-            // Bind parameters using modern API
-            if (p_params.size() > 0) {
-                std::vector<std::string> params_vec;
-                for (int i = 0; i < p_params.size(); ++i) {
-                    Variant param = p_params[i];
-                    if (param.get_type() == Variant::NIL) {
-                        params_vec.push_back("");  // Handle NULL values
-                    } else if (param.get_type() == Variant::INT) {
-                        params_vec.push_back(std::to_string(param.operator int64_t()));
-                    } else if (param.get_type() == Variant::STRING) {
-                        params_vec.push_back(param.operator String().utf8().get_data());
-                    } else if (param.get_type() == Variant::FLOAT) {
-                        params_vec.push_back(std::to_string(param.operator double()));
-                    } else if (param.get_type() == Variant::BOOL) {
-                        params_vec.push_back(param.operator bool() ? "true" : "false");
-                    } else if (param.get_type() == Variant::VECTOR2) {
-                        Vector2 v = param.operator Vector2();
-                        params_vec.push_back("(" + std::to_string(v.x) + "," + std::to_string(v.y) + ")");
-                    } else if (param.get_type() == Variant::VECTOR3) {
-                        Vector3 v = param.operator Vector3();
-                        params_vec.push_back("(" + std::to_string(v.x) + "," + std::to_string(v.y) + "," + std::to_string(v.z) + ")");
-                    } else {
-                        UtilityFunctions::print("Unsupported parameter type: ", param.get_type());
-                        connection_pool->release(conn);
-                        return result_array;
-                    }
-                }
-                
-                // Use exec_params for parameter binding
-                if (params_vec.size() == 1) {
-                    R = W.exec_params(p_query.utf8().get_data(), params_vec[0]);
-                } else if (params_vec.size() == 2) {
-                    R = W.exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1]);
-                } else if (params_vec.size() == 3) {
-                    R = W.exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1], params_vec[2]);
-                } else if (params_vec.size() == 4) {
-                    R = W.exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1], params_vec[2], params_vec[3]);
-                } else if (params_vec.size() == 5) {
-                    R = W.exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1], params_vec[2], params_vec[3], params_vec[4]);
-                } else {
-                    UtilityFunctions::print("Error: Too many parameters (max 5 supported)");
-                    return Array();
-                }
-            } else {
-                R = W.exec(p_query.utf8().get_data());
+            QueryScratch &scratch = p_pool->scratch(conn);
+            pqxx::zview query_text = scratch.encode_query(p_query);
+            if (!scratch.encode_params(p_params, r_error)) {
+                UtilityFunctions::print(r_error);
+                p_pool->release(conn);
+                return false;
             }
-   W.commit();
 
+            _log_verbose("Creating pqxx::work object for query...");
+            pqxx::work W(*conn);
+            _log_verbose("Executing query: ", p_query);
+
+            pqxx::result R = exec_encoded(W, scratch, query_text, trace_hash);
+            {
+                TraceSpan span("commit", trace_hash);
+                W.commit();
+            }
 
-            UtilityFunctions::print("Processing query results...");
-            for (pqxx::row const &row : R) {
-                Dictionary godot_row;
-                for (pqxx::field const &field : row) {
-                    godot_row[field.name()] = String(field.c_str());
+            _log_verbose("Processing query results...");
+            {
+                TraceSpan span("convert", trace_hash);
+                span.set_rows((int64_t)R.size());
+                if (!p_converter) {
+                    scratch.convert_result(R, result_array);
+                } else if (!p_converter(R, result_array, r_error)) {
+                    UtilityFunctions::print("Result conversion failed: ", r_error);
+                    p_pool->release(conn);
+                    return false;
                 }
-                result_array.append(godot_row);
             }
-            UtilityFunctions::print("Query executed successfully. Rows returned: ", (int)result_array.size());
-            connection_pool->release(conn);
-            return result_array; // Success, exit loop
+            _log_verbose("Query executed successfully. Rows returned: ", (int)result_array.size());
+            p_pool->release(conn);
+            _note_query_timing(p_pool, p_query, p_params, ticks_usec() - started_usec, wait_usec, result_array.size());
+            return true; // Success, exit loop
         } catch (const pqxx::broken_connection &e) {
             UtilityFunctions::print("Query execution failed (broken connection): ", e.what());
-            // Connection is broken, don't return it to pool
+            // Connection is broken, replace it instead of returning it to the pool
+            p_pool->discard(conn);
             conn = nullptr;
+            result_array.clear();
             if (retries == 0) { // Only retry once
                 UtilityFunctions::print("Attempting to get new connection and retry query...");
                 continue; // Retry
             } else {
                 UtilityFunctions::print("Failed after retry for query. Giving up.");
-                return result_array;
+                r_error = String(e.what());
+                return false;
             }
         } catch (const std::exception &e) {
             UtilityFunctions::print("Query execution failed with std::exception: ", e.what());
-            connection_pool->release(conn);
-            return result_array; // Other error, no retry
+            p_pool->release(conn);
+            r_error = String(e.what());
+            return false; // Other error, no retry
         } catch (...) { // Catch any other unexpected exceptions
             UtilityFunctions::print("Query execution failed with an unknown exception.");
-            connection_pool->release(conn);
-            return result_array;
+            p_pool->release(conn);
+            r_error = "Unknown exception";
+            return false;
         }
     }
     UtilityFunctions::print("Query execution loop finished without returning. This should not happen.");
-    connection_pool->release(conn);
-    return result_array; // Should not be reached if successful or failed after retries
+    if (conn) {
+        p_pool->release(conn);
+    }
+    r_error = "Query execution loop finished without returning";
+    return false; // Should not be reached if successful or failed after retries
 }
 
 int PostgreAdapter::execute_non_query(const String &p_query, const Array& p_params /*= Array()*/) {
+	recorder.record(workload::API_NON_QUERY, p_query, p_params);
 	int affected_rows = -1;
-	UtilityFunctions::print("execute_non_query called with query: ", p_query);
+	String error;
+	std::shared_ptr<ConnectionPool> pool = get_pool();
+	if (!pool) {
+		UtilityFunctions::print("Connection pool is not initialized. Set connection_string first.");
+		emit_signal_threadsafe("connection_error", "Connection pool not initialized");
+		return affected_rows;
+	}
+	if (!_execute_non_query(pool, p_query, p_params, affected_rows, error)) {
+		return -1;
+	}
+	return affected_rows;
+}
+
+bool PostgreAdapter::_execute_non_query(const std::shared_ptr<ConnectionPool> &p_pool, const String &p_query, const Array &p_params, int &r_affected_rows, String &r_error) {
+	int &affected_rows = r_affected_rows;
+	affected_rows = -1;
+	_log_verbose("execute_non_query called with query: ", p_query);
     if (!p_params.is_empty()) {
-        UtilityFunctions::print("execute_non_query called with params: ", p_params);
+        _log_verbose("execute_non_query called with params: ", p_params);
     }
 
-    pqxx::connection* conn = connection_pool->acquire();
+    uint64_t started_usec = ticks_usec();
+    uint64_t wait_usec = 0;
+    uint32_t trace_hash = QueryTracer::query_hash(p_query);
+    pqxx::connection* conn = acquire_timed(*p_pool, acquire_timeout_ms.load(std::memory_order_relaxed), wait_usec);
     if (!conn) {
         UtilityFunctions::print("Failed to acquire connection from pool.");
-        return affected_rows;
+        r_error = "Failed to acquire connection from pool";
+        return false;
     }
 
 	for (int retries = 0; retries < 2; ++retries) { // Allow one retry
-		UtilityFunctions::print("Attempting non-query, retry #", retries);
+		_log_verbose("Attempting non-query, retry #", retries);
 		if (!conn || !conn->is_open()) {
 			UtilityFunctions::print("Connection not open for non-query, will need new connection.");
-			// Return this connection to pool and get a new one
+			// Replace the dead connection and get a new one
 			if (conn) {
-				connection_pool->release(conn);
+				p_pool->discard(conn);
 			}
-			conn = connection_pool->acquire();
+			conn = acquire_timed(*p_pool, acquire_timeout_ms.load(std::memory_order_relaxed), wait_usec);
 			if (!conn) {
 				UtilityFunctions::print("Failed to acquire new connection from pool.");
-				return -1;
+				r_error = "Failed to acquire connection from pool";
+				return false;
 			}
 		}
 
 		// Ensure connection is valid before proceeding with transaction/query
-		ERR_FAIL_COND_V_MSG(!conn->is_open(), -1, "PostgreSQL connection is not valid or open before executing non-query.");
+		if (!conn->is_open()) {
+			p_pool->release(conn);
+			r_error = "PostgreSQL connection is not valid or open";
+			ERR_FAIL_V_MSG(false, "PostgreSQL connection is not valid or open before executing non-query.");
+		}
 
 		try {
-			UtilityFunctions::print("DEBUG: Before pqxx::work W(*conn);");
+			QueryScratch &scratch = p_pool->scratch(conn);
+			pqxx::zview query_text = scratch.encode_query(p_query);
+			if (!scratch.encode_params(p_params, r_error)) {
+				UtilityFunctions::print(r_error);
+				p_pool->release(conn);
+				return false;
+			}
+
+			_log_verbose("DEBUG: Before pqxx::work W(*conn);");
 			pqxx::work W(*conn);
-			UtilityFunctions::print("DEBUG: After pqxx::work W(*conn); Before W.exec();");
-			         pqxx::result R; // Declare R here
-			         if (p_params.size() > 0) {
-			             std::vector<std::string> params_vec;
-			             for (int i = 0; i < p_params.size(); ++i) {
-			                 Variant param = p_params[i];
-			                 if (param.get_type() == Variant::INT) {
-			                     params_vec.push_back(std::to_string(param.operator int64_t()));
-			                 } else if (param.get_type() == Variant::STRING) {
-			                     params_vec.push_back(param.operator String().utf8().get_data());
-			                 } else if (param.get_type() == Variant::FLOAT) {
-			                     params_vec.push_back(std::to_string(param.operator double()));
-			                 } else if (param.get_type() == Variant::BOOL) {
-			                     params_vec.push_back(param.operator bool() ? "true" : "false");
-			                 } else {
-			                     UtilityFunctions::print("Unsupported parameter type for non-query: ", param.get_type());
-			                     connection_pool->release(conn);
-			                     return -1;
-			                 }
-			             }
-			             // Use exec_params for parameter binding
-			             if (params_vec.size() == 1) {
-			                 R = W.exec_params(p_query.utf8().get_data(), params_vec[0]);
-			             } else if (params_vec.size() == 2) {
-			                 R = W.exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1]);
-			             } else if (params_vec.size() == 3) {
-			                 R = W.exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1], params_vec[2]);
-			             } else if (params_vec.size() == 4) {
-			                 R = W.exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1], params_vec[2], params_vec[3]);
-			             } else if (params_vec.size() == 5) {
-			                 R = W.exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1], params_vec[2], params_vec[3], params_vec[4]);
-			             } else {
-			                 UtilityFunctions::print("Error: Too many parameters (max 5 supported)");
-			                 connection_pool->release(conn);
-			                 return -1;
-			             }
-			         } else {
-			             R = W.exec(p_query.utf8().get_data());
-			         }
-			UtilityFunctions::print("DEBUG: After W.exec(); Before W.commit();");
-			W.commit();
-			UtilityFunctions::print("DEBUG: After W.commit();");
+			_log_verbose("DEBUG: After pqxx::work W(*conn); Before W.exec();");
+			pqxx::result R = exec_encoded(W, scratch, query_text, trace_hash);
+			_log_verbose("DEBUG: After W.exec(); Before W.commit();");
+			{
+				TraceSpan span("commit", trace_hash);
+				W.commit();
+			}
+			_log_verbose("DEBUG: After W.commit();");
 			
 			// Check if this is a DDL statement that doesn't support affected_rows()
-			String query_upper = p_query.to_upper().strip_edges();
-			bool is_ddl = query_upper.begins_with("CREATE") ||
-						  query_upper.begins_with("DROP") ||
-						  query_upper.begins_with("ALTER") ||
-						  query_upper.begins_with("TRUNCATE");
+			bool is_ddl = scratch.is_ddl();
 			
 			if (is_ddl) {
-				UtilityFunctions::print("DEBUG: DDL statement detected, skipping affected_rows()");
+				_log_verbose("DEBUG: DDL statement detected, skipping affected_rows()");
 				affected_rows = 0; // DDL statements executed successfully
 			} else {
-				UtilityFunctions::print("DEBUG: Before R.affected_rows();");
+				_log_verbose("DEBUG: Before R.affected_rows();");
 				try {
 					affected_rows = R.affected_rows();
-					UtilityFunctions::print("DEBUG: After R.affected_rows(); Before final print.");
+					_log_verbose("DEBUG: After R.affected_rows(); Before final print.");
 				} catch (const std::exception &e) {
 					UtilityFunctions::print("DEBUG: Exception caught when calling R.affected_rows(): ", e.what());
 					affected_rows = 0;
@@ -382,79 +846,270 @@ int PostgreAdapter::execute_non_query(const String &p_query, const Array& p_para
 					affected_rows = 0;
 				}
 			}
-			UtilityFunctions::print("Non-query executed successfully. Affected rows: ", affected_rows);
-			UtilityFunctions::print("DEBUG: Before returning affected_rows.");
-			         connection_pool->release(conn);
-			return affected_rows; // Success, exit loop
+			_log_verbose("Non-query executed successfully. Affected rows: ", affected_rows);
+			_log_verbose("DEBUG: Before returning affected_rows.");
+			p_pool->release(conn);
+			_note_query_timing(p_pool, p_query, p_params, ticks_usec() - started_usec, wait_usec, affected_rows);
+			return true; // Success, exit loop
 		} catch (const pqxx::broken_connection &e) {
 			UtilityFunctions::print("Non-query execution failed (broken connection): ", e.what());
-			// Connection is broken, don't return it to pool
+			// Connection is broken, replace it instead of returning it to the pool
+			p_pool->discard(conn);
 			conn = nullptr;
 			if (retries == 0) { // Only retry once
 				UtilityFunctions::print("Attempting to get new connection and retry non-query...");
 				continue; // Retry
 			} else {
 				UtilityFunctions::print("Failed after retry for non-query. Giving up.");
-				return -1;
+				r_error = String(e.what());
+				return false;
 			}
 		} catch (const std::exception &e) {
 			UtilityFunctions::print("Non-query execution failed with std::exception: ", e.what());
-            connection_pool->release(conn);
-			return -1; // Other error, no retry
+            p_pool->release(conn);
+			r_error = String(e.what());
+			return false; // Other error, no retry
 		} catch (...) { // Catch any other unexpected exceptions
 			UtilityFunctions::print("Non-query execution failed with an unknown exception.");
-            connection_pool->release(conn);
-			return -1;
+            p_pool->release(conn);
+			r_error = "Unknown exception";
+			return false;
 		}
 	}
 	UtilityFunctions::print("Non-query execution loop finished without returning. This should not happen.");
-    connection_pool->release(conn);
-	return affected_rows; // Should not be reached if successful or failed after retries
+	if (conn) {
+		p_pool->release(conn);
+	}
+	r_error = "Non-query execution loop finished without returning";
+	return false; // Should not be reached if successful or failed after retries
+}
+
+// Sharded mode. Every shard gets its own pool of pool_size connections.
+void PostgreAdapter::set_shard_connection_strings(const PackedStringArray &p_connection_strings) {
+	int size;
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		shard_connection_strings = p_connection_strings;
+		size = pool_size;
+	}
+	_rebuild_shard_pools(p_connection_strings, size);
+}
+
+PackedStringArray PostgreAdapter::get_shard_connection_strings() const {
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	return shard_connection_strings;
+}
+
+void PostgreAdapter::_rebuild_shard_pools(const PackedStringArray &p_connection_strings, int p_pool_size) {
+	std::vector<std::shared_ptr<ConnectionPool>> new_pools;
+	new_pools.reserve(p_connection_strings.size());
+	for (int64_t i = 0; i < p_connection_strings.size(); ++i) {
+		UtilityFunctions::print("Creating pool for shard ", i);
+		new_pools.push_back(_create_pool(p_connection_strings[i], p_pool_size));
+	}
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		shard_pools.swap(new_pools);
+	}
+	_update_worker_count();
+}
+
+int PostgreAdapter::get_shard_count() const {
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	return (int)shard_pools.size();
+}
+
+// Integer keys map to key mod shard_count so sequential ids spread evenly and
+// an existing "id % N" split keeps working. Floats with an integral value
+// count as integers, since JSON.parse returns every number as a float and
+// 42.0 must land where 42 does. Any other key is hashed with FNV-1a over its
+// UTF-8 text, which is stable across runs and platforms.
+static int shard_index_for_key(const Variant &p_key, int p_shard_count) {
+	bool integral = p_key.get_type() == Variant::INT;
+	if (p_key.get_type() == Variant::FLOAT) {
+		double value = p_key.operator double();
+		// 2^63 bounds the int64 range; NaN fails both comparisons
+		integral = value >= -9223372036854775808.0 && value < 9223372036854775808.0 && std::trunc(value) == value;
+	}
+	if (integral) {
+		int64_t key = p_key.operator int64_t();
+		int64_t index = key % p_shard_count;
+		return (int)(index < 0 ? index + p_shard_count : index);
+	}
+	CharString text = p_key.stringify().utf8();
+	uint64_t hash = 14695981039346656037ULL;
+	for (const char *c = text.get_data(); *c; ++c) {
+		hash ^= (uint8_t)*c;
+		hash *= 1099511628211ULL;
+	}
+	return (int)(hash % (uint64_t)p_shard_count);
+}
+
+int PostgreAdapter::get_shard_for_key(const Variant &p_key) const {
+	int shard_count = get_shard_count();
+	if (shard_count == 0) {
+		return -1;
+	}
+	return shard_index_for_key(p_key, shard_count);
+}
+
+std::shared_ptr<ConnectionPool> PostgreAdapter::get_shard_pool(const Variant &p_key, int &r_shard) const {
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	if (shard_pools.empty()) {
+		r_shard = -1;
+		return nullptr;
+	}
+	r_shard = shard_index_for_key(p_key, (int)shard_pools.size());
+	return shard_pools[r_shard];
+}
+
+Array PostgreAdapter::execute_query_sharded(const Variant &p_key, const String &p_query, const Array& p_params) {
+	recorder.record(workload::API_QUERY, p_query, p_params);
+	Array result_array;
+	int shard = -1;
+	std::shared_ptr<ConnectionPool> pool = get_shard_pool(p_key, shard);
+	if (!pool) {
+		UtilityFunctions::print("No shards configured. Set shard_connection_strings first.");
+		emit_signal_threadsafe("connection_error", "No shards configured");
+		return result_array;
+	}
+	String error;
+	if (!_execute_read(pool, p_query, p_params, result_array, error)) {
+		emit_signal_threadsafe("query_failed", p_query, String("Shard ") + String::num_int64(shard) + ": " + error);
+	}
+	return result_array;
+}
+
+int PostgreAdapter::execute_non_query_sharded(const Variant &p_key, const String &p_query, const Array& p_params) {
+	recorder.record(workload::API_NON_QUERY, p_query, p_params);
+	int shard = -1;
+	std::shared_ptr<ConnectionPool> pool = get_shard_pool(p_key, shard);
+	if (!pool) {
+		UtilityFunctions::print("No shards configured. Set shard_connection_strings first.");
+		emit_signal_threadsafe("connection_error", "No shards configured");
+		return -1;
+	}
+	int affected_rows = -1;
+	String error;
+	if (!_execute_non_query(pool, p_query, p_params, affected_rows, error)) {
+		emit_signal_threadsafe("non_query_failed", p_query, String("Shard ") + String::num_int64(shard) + ": " + error);
+		return -1;
+	}
+	return affected_rows;
+}
+
+// Runs the query on every shard at once, on the adapter's worker threads,
+// and concatenates the rows in shard order. Shards that fail are reported
+// through query_failed; rows from the others are still returned.
+Array PostgreAdapter::execute_query_all_shards(const String &p_query, const Array& p_params) {
+	recorder.record(workload::API_QUERY, p_query, p_params);
+	std::vector<std::shared_ptr<ConnectionPool>> pools;
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		pools = shard_pools;
+	}
+	Array merged;
+	if (pools.empty()) {
+		UtilityFunctions::print("No shards configured. Set shard_connection_strings first.");
+		emit_signal_threadsafe("connection_error", "No shards configured");
+		return merged;
+	}
+
+	size_t shard_count = pools.size();
+	std::shared_ptr<ShardScatter> scatter = std::make_shared<ShardScatter>();
+	scatter->pools = pools;
+	scatter->query = p_query;
+	scatter->params = p_params;
+	scatter->results.resize(shard_count);
+	scatter->errors.resize(shard_count);
+	scatter->succeeded.resize(shard_count, 0);
+	scatter->remaining = shard_count - 1;
+
+	// The calling thread takes shard 0 itself
+	for (size_t i = 1; i < shard_count; ++i) {
+		workers.submit([this, scatter, i]() { _run_shard_read(scatter, i); });
+	}
+	scatter->succeeded[0] = _execute_read(pools[0], p_query, p_params, scatter->results[0], scatter->errors[0]);
+	{
+		std::unique_lock<std::mutex> lock(scatter->mutex);
+		scatter->done.wait(lock, [&scatter] { return scatter->remaining == 0; });
+	}
+
+	for (size_t i = 0; i < shard_count; ++i) {
+		if (scatter->succeeded[i]) {
+			merged.append_array(scatter->results[i]);
+		} else {
+			emit_signal_threadsafe("query_failed", p_query, String("Shard ") + String::num_int64((int64_t)i) + ": " + scatter->errors[i]);
+		}
+	}
+	return merged;
+}
+
+// Reads one shard of a scatter-gather call. Each read writes only its own slot.
+void PostgreAdapter::_run_shard_read(const std::shared_ptr<ShardScatter> &p_scatter, size_t p_index) {
+	p_scatter->succeeded[p_index] = _execute_read(p_scatter->pools[p_index], p_scatter->query, p_scatter->params, p_scatter->results[p_index], p_scatter->errors[p_index]);
+	std::lock_guard<std::mutex> lock(p_scatter->mutex);
+	if (--p_scatter->remaining == 0) {
+		p_scatter->done.notify_one();
+	}
 }
 
 String PostgreAdapter::_to_string() const {
+	std::lock_guard<std::mutex> lock(pool_mutex);
 	return String("PostgreAdapter (Pool: ") + (connection_pool ? "Available" : "Not initialized") + String(", String: '") + connection_string + String("')");
 }
 
 // Transaction support methods
 bool PostgreAdapter::begin_transaction() {
+	std::lock_guard<std::recursive_mutex> tx_lock(transaction_mutex);
+	TraceSpan span("transaction_begin");
+	recorder.record(workload::API_BEGIN_TRANSACTION);
 	if (in_transaction) {
 		UtilityFunctions::print("Transaction already in progress");
 		return false;
 	}
 	
-	if (!connection_pool) {
+	std::shared_ptr<ConnectionPool> pool = get_pool();
+	if (!pool) {
 		UtilityFunctions::print("Connection pool not initialized");
-		emit_signal("transaction_failed", "Connection pool not initialized");
+		emit_signal_threadsafe("transaction_failed", "Connection pool not initialized");
 		return false;
 	}
 	
-	transaction_connection = connection_pool->acquire();
+	transaction_connection = pool->acquire(acquire_timeout_ms.load(std::memory_order_relaxed));
 	if (!transaction_connection || !transaction_connection->is_open()) {
 		UtilityFunctions::print("Failed to acquire connection for transaction");
-		emit_signal("transaction_failed", "Failed to acquire connection");
+		if (transaction_connection) {
+			pool->discard(transaction_connection);
+			transaction_connection = nullptr;
+		}
+		emit_signal_threadsafe("transaction_failed", "Failed to acquire connection");
 		return false;
 	}
 	
 	try {
 		current_transaction = new pqxx::work(*transaction_connection);
+		transaction_pool = pool;
 		in_transaction = true;
 		UtilityFunctions::print("Transaction started successfully");
-		emit_signal("transaction_started");
+		emit_signal_threadsafe("transaction_started");
 		return true;
 	} catch (const std::exception &e) {
 		UtilityFunctions::print("Failed to start transaction: ", e.what());
-		connection_pool->release(transaction_connection);
+		pool->release(transaction_connection);
 		transaction_connection = nullptr;
-		emit_signal("transaction_failed", String(e.what()));
+		emit_signal_threadsafe("transaction_failed", String(e.what()));
 		return false;
 	}
 }
 
 bool PostgreAdapter::commit_transaction() {
+	std::lock_guard<std::recursive_mutex> tx_lock(transaction_mutex);
+	TraceSpan span("transaction_commit");
+	recorder.record(workload::API_COMMIT_TRANSACTION);
 	if (!in_transaction || !current_transaction) {
 		UtilityFunctions::print("No active transaction to commit");
-		emit_signal("transaction_failed", "No active transaction");
+		emit_signal_threadsafe("transaction_failed", "No active transaction");
 		return false;
 	}
 	
@@ -463,23 +1118,26 @@ bool PostgreAdapter::commit_transaction() {
 		delete current_transaction;
 		current_transaction = nullptr;
 		
-		connection_pool->release(transaction_connection);
+		transaction_pool->release(transaction_connection);
 		transaction_connection = nullptr;
+		transaction_pool.reset();
 		
 		in_transaction = false;
 		UtilityFunctions::print("Transaction committed successfully");
-		emit_signal("transaction_committed");
+		emit_signal_threadsafe("transaction_committed");
 		return true;
 	} catch (const std::exception &e) {
 		UtilityFunctions::print("Failed to commit transaction: ", e.what());
 		// Clean up failed transaction
 		rollback_transaction();
-		emit_signal("transaction_failed", String(e.what()));
+		emit_signal_threadsafe("transaction_failed", String(e.what()));
 		return false;
 	}
 }
 
 bool PostgreAdapter::rollback_transaction() {
+	std::lock_guard<std::recursive_mutex> tx_lock(transaction_mutex);
+	recorder.record(workload::API_ROLLBACK_TRANSACTION);
 	if (!in_transaction || !current_transaction) {
 		UtilityFunctions::print("No active transaction to rollback");
 		return false;
@@ -490,12 +1148,13 @@ bool PostgreAdapter::rollback_transaction() {
 		delete current_transaction;
 		current_transaction = nullptr;
 		
-		connection_pool->release(transaction_connection);
+		transaction_pool->release(transaction_connection);
 		transaction_connection = nullptr;
+		transaction_pool.reset();
 		
 		in_transaction = false;
 		UtilityFunctions::print("Transaction rolled back successfully");
-		emit_signal("transaction_rolled_back");
+		emit_signal_threadsafe("transaction_rolled_back");
 		return true;
 	} catch (const std::exception &e) {
 		UtilityFunctions::print("Error during rollback: ", e.what());
@@ -503,177 +1162,194 @@ bool PostgreAdapter::rollback_transaction() {
 		delete current_transaction;
 		current_transaction = nullptr;
 		if (transaction_connection) {
-			connection_pool->release(transaction_connection);
+			transaction_pool->release(transaction_connection);
 			transaction_connection = nullptr;
 		}
+		transaction_pool.reset();
 		in_transaction = false;
-		emit_signal("transaction_failed", String(e.what()));
+		emit_signal_threadsafe("transaction_failed", String(e.what()));
 		return false;
 	}
 }
 
 Array PostgreAdapter::execute_query_in_transaction(const String &p_query, const Array& p_params) {
+	recorder.record(workload::API_QUERY_IN_TRANSACTION, p_query, p_params);
 	Array result_array;
+	std::lock_guard<std::recursive_mutex> tx_lock(transaction_mutex);
 	
 	if (!in_transaction || !current_transaction) {
 		UtilityFunctions::print("No active transaction");
-		emit_signal("query_failed", p_query, "No active transaction");
+		emit_signal_threadsafe("query_failed", p_query, "No active transaction");
 		return result_array;
 	}
 	
 	try {
-		pqxx::result R;
-		
-		// Handle parameters
-		if (p_params.size() > 0) {
-			std::vector<std::string> params_vec;
-			for (int i = 0; i < p_params.size(); ++i) {
-				Variant param = p_params[i];
-				if (param.get_type() == Variant::NIL) {
-					params_vec.push_back("");
-				} else if (param.get_type() == Variant::INT) {
-					params_vec.push_back(std::to_string(param.operator int64_t()));
-				} else if (param.get_type() == Variant::STRING) {
-					params_vec.push_back(param.operator String().utf8().get_data());
-				} else if (param.get_type() == Variant::FLOAT) {
-					params_vec.push_back(std::to_string(param.operator double()));
-				} else if (param.get_type() == Variant::BOOL) {
-					params_vec.push_back(param.operator bool() ? "true" : "false");
-				} else if (param.get_type() == Variant::VECTOR2) {
-					Vector2 v = param.operator Vector2();
-					params_vec.push_back("(" + std::to_string(v.x) + "," + std::to_string(v.y) + ")");
-				} else if (param.get_type() == Variant::VECTOR3) {
-					Vector3 v = param.operator Vector3();
-					params_vec.push_back("(" + std::to_string(v.x) + "," + std::to_string(v.y) + "," + std::to_string(v.z) + ")");
-				}
-			}
-			// Use exec_params for parameter binding
-			if (params_vec.size() == 1) {
-				R = current_transaction->exec_params(p_query.utf8().get_data(), params_vec[0]);
-			} else if (params_vec.size() == 2) {
-				R = current_transaction->exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1]);
-			} else if (params_vec.size() == 3) {
-				R = current_transaction->exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1], params_vec[2]);
-			} else if (params_vec.size() == 4) {
-				R = current_transaction->exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1], params_vec[2], params_vec[3]);
-			} else if (params_vec.size() == 5) {
-				R = current_transaction->exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1], params_vec[2], params_vec[3], params_vec[4]);
-			} else {
-				UtilityFunctions::print("Error: Too many parameters (max 5 supported)");
-				return Array();
-			}
-		} else {
-			R = current_transaction->exec(p_query.utf8().get_data());
+		QueryScratch &scratch = transaction_pool->scratch(transaction_connection);
+		pqxx::zview query_text = scratch.encode_query(p_query);
+		String error;
+		if (!scratch.encode_params(p_params, error)) {
+			UtilityFunctions::print(error);
+			emit_signal_threadsafe("query_failed", p_query, error);
+			return result_array;
 		}
+
+		uint64_t started_usec = ticks_usec();
+		uint32_t trace_hash = QueryTracer::query_hash(p_query);
+		pqxx::result R = exec_encoded(*current_transaction, scratch, query_text, trace_hash);
 		
 		// Process results
-		for (pqxx::row const &row : R) {
-			Dictionary godot_row;
-			for (pqxx::field const &field : row) {
-				godot_row[field.name()] = String(field.c_str());
-			}
-			result_array.append(godot_row);
+		{
+			TraceSpan span("convert", trace_hash);
+			span.set_rows((int64_t)R.size());
+			scratch.convert_result(R, result_array);
 		}
 		
-		UtilityFunctions::print("Query in transaction executed successfully. Rows returned: ", (int)result_array.size());
+		_log_verbose("Query in transaction executed successfully. Rows returned: ", (int)result_array.size());
+		_note_query_timing(transaction_pool, p_query, p_params, ticks_usec() - started_usec, 0, result_array.size());
 		return result_array;
 		
 	} catch (const std::exception &e) {
 		UtilityFunctions::print("Query in transaction failed: ", e.what());
-		emit_signal("query_failed", p_query, String(e.what()));
+		emit_signal_threadsafe("query_failed", p_query, String(e.what()));
 		return result_array;
 	}
 }
 
 int PostgreAdapter::execute_non_query_in_transaction(const String &p_query, const Array& p_params) {
+	recorder.record(workload::API_NON_QUERY_IN_TRANSACTION, p_query, p_params);
+	std::lock_guard<std::recursive_mutex> tx_lock(transaction_mutex);
 	if (!in_transaction || !current_transaction) {
 		UtilityFunctions::print("No active transaction");
-		emit_signal("non_query_failed", p_query, "No active transaction");
+		emit_signal_threadsafe("non_query_failed", p_query, "No active transaction");
 		return -1;
 	}
 	
 	try {
-		pqxx::result R;
-		
-		// Handle parameters
-		if (p_params.size() > 0) {
-			std::vector<std::string> params_vec;
-			for (int i = 0; i < p_params.size(); ++i) {
-				Variant param = p_params[i];
-				if (param.get_type() == Variant::NIL) {
-					params_vec.push_back("");
-				} else if (param.get_type() == Variant::INT) {
-					params_vec.push_back(std::to_string(param.operator int64_t()));
-				} else if (param.get_type() == Variant::STRING) {
-					params_vec.push_back(param.operator String().utf8().get_data());
-				} else if (param.get_type() == Variant::FLOAT) {
-					params_vec.push_back(std::to_string(param.operator double()));
-				} else if (param.get_type() == Variant::BOOL) {
-					params_vec.push_back(param.operator bool() ? "true" : "false");
-				} else if (param.get_type() == Variant::VECTOR2) {
-					Vector2 v = param.operator Vector2();
-					params_vec.push_back("(" + std::to_string(v.x) + "," + std::to_string(v.y) + ")");
-				} else if (param.get_type() == Variant::VECTOR3) {
-					Vector3 v = param.operator Vector3();
-					params_vec.push_back("(" + std::to_string(v.x) + "," + std::to_string(v.y) + "," + std::to_string(v.z) + ")");
-				}
-			}
-			// Use exec_params for parameter binding
-			if (params_vec.size() == 1) {
-				R = current_transaction->exec_params(p_query.utf8().get_data(), params_vec[0]);
-			} else if (params_vec.size() == 2) {
-				R = current_transaction->exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1]);
-			} else if (params_vec.size() == 3) {
-				R = current_transaction->exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1], params_vec[2]);
-			} else if (params_vec.size() == 4) {
-				R = current_transaction->exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1], params_vec[2], params_vec[3]);
-			} else if (params_vec.size() == 5) {
-				R = current_transaction->exec_params(p_query.utf8().get_data(), params_vec[0], params_vec[1], params_vec[2], params_vec[3], params_vec[4]);
-			} else {
-				UtilityFunctions::print("Error: Too many parameters (max 5 supported)");
-				return -1;
-			}
-		} else {
-			R = current_transaction->exec(p_query.utf8().get_data());
+		QueryScratch &scratch = transaction_pool->scratch(transaction_connection);
+		pqxx::zview query_text = scratch.encode_query(p_query);
+		String error;
+		if (!scratch.encode_params(p_params, error)) {
+			UtilityFunctions::print(error);
+			emit_signal_threadsafe("non_query_failed", p_query, error);
+			return -1;
 		}
+
+		uint64_t started_usec = ticks_usec();
+		uint32_t trace_hash = QueryTracer::query_hash(p_query);
+		pqxx::result R = exec_encoded(*current_transaction, scratch, query_text, trace_hash);
 		
 		// Check affected rows
-		String query_upper = p_query.to_upper().strip_edges();
-		bool is_ddl = query_upper.begins_with("CREATE") ||
-					  query_upper.begins_with("DROP") ||
-					  query_upper.begins_with("ALTER") ||
-					  query_upper.begins_with("TRUNCATE");
+		bool is_ddl = scratch.is_ddl();
 		
 		int affected_rows = is_ddl ? 0 : R.affected_rows();
-		UtilityFunctions::print("Non-query in transaction executed successfully. Affected rows: ", affected_rows);
+		_log_verbose("Non-query in transaction executed successfully. Affected rows: ", affected_rows);
+		_note_query_timing(transaction_pool, p_query, p_params, ticks_usec() - started_usec, 0, affected_rows);
 		return affected_rows;
 		
 	} catch (const std::exception &e) {
 		UtilityFunctions::print("Non-query in transaction failed: ", e.what());
-		emit_signal("non_query_failed", p_query, String(e.what()));
+		emit_signal_threadsafe("non_query_failed", p_query, String(e.what()));
 		return -1;
 	}
 }
 
-// Async query methods (using call_deferred for simplicity)
-void PostgreAdapter::execute_query_async(const String &p_query, const Array& p_params) {
-	// For now, we'll execute synchronously and emit the signal
-	// In a real async implementation, you'd use threading or Godot's WorkerThreadPool
-	Array result = execute_query(p_query, p_params);
-	if (result.size() >= 0) {  // Even empty results are successful
-		call_deferred("emit_signal", "query_completed", result);
+// Async query methods run on the adapter's own worker threads, one per pooled
+// connection. Each call takes its own connection, so throughput scales with
+// pool_size instead of being capped by the WorkerThreadPool's share of
+// low-priority threads.
+// Results are queued for the main thread and delivered under the per-frame
+// dispatch budget, highest priority first.
+// Tasks get their own copy of the parameters: the caller may reuse or change
+// its Array as soon as the call returns.
+int64_t PostgreAdapter::execute_query_async(const String &p_query, const Array& p_params, int p_priority) {
+	recorder.record(workload::API_QUERY_ASYNC, p_query, p_params);
+	int64_t request_id = next_request_id++;
+	_submit_task(callable_mp(this, &PostgreAdapter::_run_query_task).bind(p_query, p_params.duplicate(), request_id, p_priority));
+	return request_id;
+}
+
+int64_t PostgreAdapter::execute_non_query_async(const String &p_query, const Array& p_params, int p_priority) {
+	recorder.record(workload::API_NON_QUERY_ASYNC, p_query, p_params);
+	int64_t request_id = next_request_id++;
+	_submit_task(callable_mp(this, &PostgreAdapter::_run_non_query_task).bind(p_query, p_params.duplicate(), request_id, p_priority));
+	return request_id;
+}
+
+void PostgreAdapter::_run_query_task(const String &p_query, const Array &p_params, int64_t p_request_id, int p_priority) {
+	Array result;
+	String error = "Connection pool not initialized";
+	std::shared_ptr<ConnectionPool> pool = get_pool();
+	if (pool && _execute_read(pool, p_query, p_params, result, error)) {
+		dispatcher.push_result(p_request_id, result, p_priority);
 	} else {
-		call_deferred("emit_signal", "async_query_failed", p_query, "Query execution failed");
+		Array args;
+		args.push_back(p_query);
+		args.push_back(error);
+		dispatcher.push_request_signal("async_query_failed", "async_request_failed", p_request_id, args, p_priority);
 	}
+	_schedule_dispatch();
 }
 
-void PostgreAdapter::execute_non_query_async(const String &p_query, const Array& p_params) {
-	// For now, we'll execute synchronously and emit the signal
-	// In a real async implementation, you'd use threading or Godot's WorkerThreadPool
-	int result = execute_non_query(p_query, p_params);
-	if (result >= 0) {
-		call_deferred("emit_signal", "non_query_completed", result);
+void PostgreAdapter::_run_non_query_task(const String &p_query, const Array &p_params, int64_t p_request_id, int p_priority) {
+	int affected_rows = -1;
+	String error = "Connection pool not initialized";
+	std::shared_ptr<ConnectionPool> pool = get_pool();
+	Array args;
+	if (pool && _execute_non_query(pool, p_query, p_params, affected_rows, error)) {
+		args.push_back(affected_rows);
+		dispatcher.push_request_signal("non_query_completed", "non_query_request_completed", p_request_id, args, p_priority);
 	} else {
-		call_deferred("emit_signal", "async_query_failed", p_query, "Non-query execution failed");
+		args.push_back(p_query);
+		args.push_back(error);
+		dispatcher.push_request_signal("async_query_failed", "async_request_failed", p_request_id, args, p_priority);
 	}
-}
\ No newline at end of file
+	_schedule_dispatch();
+}
+
+// Inside the tree the internal process step drains the dispatcher every
+// frame. Outside of it, fall back to a deferred call. Only one drain is ever
+// pending, so a burst of finished tasks still gets one budget per frame.
+void PostgreAdapter::_schedule_dispatch() {
+	if (!is_inside_tree() && !dispatch_scheduled.exchange(true)) {
+		callable_mp(this, &PostgreAdapter::_dispatch_pending).call_deferred();
+	}
+}
+
+void PostgreAdapter::_dispatch_pending() {
+	// Cleared before draining so a push that lands during the drain schedules the next one
+	dispatch_scheduled.store(false);
+	if (is_inside_tree()) {
+		return; // The process step has taken over
+	}
+	if (!dispatcher.drain(this, dispatch_budget_usec, result_chunk_size) || dispatch_scheduled.exchange(true)) {
+		return;
+	}
+	// Leftovers wait for the next frame; a deferred call would run again in this one
+	Callable next = callable_mp(this, &PostgreAdapter::_dispatch_pending);
+	SceneTree *tree = Object::cast_to<SceneTree>(Engine::get_singleton()->get_main_loop());
+	if (tree) {
+		tree->connect("process_frame", next, CONNECT_ONE_SHOT);
+	} else {
+		next.call_deferred();
+	}
+}
+
+void PostgreAdapter::_submit_task(const Callable &p_task) {
+	workers.submit([p_task]() { p_task.call(); });
+}
+
+// Running tasks may queue follow-up work (EXPLAIN capture); wait_idle covers that too
+void PostgreAdapter::_wait_for_pending_tasks() {
+	workers.wait_idle();
+}
+
+// Enough threads for every connection of the main pool, and for every shard
+// of a scatter-gather read
+void PostgreAdapter::_update_worker_count() {
+	int count;
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		count = pool_size > (int)shard_pools.size() ? pool_size : (int)shard_pools.size();
+	}
+	workers.set_thread_count(count);
+}
@@ -2,8 +2,25 @@
 #define POSTGRE_ADAPTER_H
 
 #include <godot_cpp/classes/node.hpp>
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
 #include <pqxx/pqxx> // Include pqxx for connection object
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "connection_pool.h"
+#include "object_mapping.h"
+#include "query_workers.h"
+#include "result_dispatcher.h"
+#include "single_flight.h"
+#include "slow_query_log.h"
+#include "workload_recorder.h"
 
 namespace godot {
 
@@ -12,13 +29,123 @@ class PostgreAdapter : public Node {
  
 private:
  	String connection_string;
-	ConnectionPool* connection_pool;
+	std::shared_ptr<ConnectionPool> connection_pool;
 	int pool_size = 4;
+	// How long a call waits for a free pooled connection before failing
+	std::atomic<int> acquire_timeout_ms{ 10000 };
+	// Guards connection_string, pool_size and connection_pool. Callers take a
+	// copy of the pool pointer, so reconfiguring never frees a pool that still
+	// has connections checked out on another thread.
+	mutable std::mutex pool_mutex;
+
+	// Sharded mode: one pool per shard, calls routed by a caller-supplied key
+	PackedStringArray shard_connection_strings;
+	std::vector<std::shared_ptr<ConnectionPool>> shard_pools;
+	// State shared by the shard reads of one execute_query_all_shards call
+	struct ShardScatter {
+		std::vector<std::shared_ptr<ConnectionPool>> pools;
+		String query;
+		Array params;
+		std::vector<Array> results;
+		std::vector<String> errors;
+		std::vector<char> succeeded;
+		std::mutex mutex;
+		std::condition_variable done;
+		size_t remaining = 0;
+	};
 	
+	// Per-statement progress logging; errors are always printed
+	std::atomic<bool> verbose_logging{ false };
+
 	// Transaction state
+	std::recursive_mutex transaction_mutex;
+	std::shared_ptr<ConnectionPool> transaction_pool;
 	pqxx::connection* transaction_connection;
 	pqxx::work* current_transaction;
 	bool in_transaction;
+
+	// Threads that run the async methods, one per pooled connection
+	QueryWorkers workers;
+	std::atomic<int64_t> next_request_id{ 1 };
+
+	// Main-thread delivery of async results, spread across frames
+	ResultDispatcher dispatcher;
+	int dispatch_budget_usec = 2000;
+	int result_chunk_size = 1000;
+	// Set while a deferred _dispatch_pending is queued (outside the tree only)
+	std::atomic<bool> dispatch_scheduled{ false };
+
+	bool owns_trace = false;
+
+	// Single-flight coalescing of identical concurrent reads
+	std::atomic<bool> coalesce_reads{ false };
+	SingleFlight in_flight_reads;
+
+	WorkloadRecorder recorder;
+
+	// Slow-query log
+	std::atomic<double> slow_query_threshold_ms{ 0.0 };
+	std::atomic<bool> capture_explain{ false };
+	SlowQueryLog slow_queries;
+	struct ExplainJob {
+		std::shared_ptr<ConnectionPool> pool;
+		Dictionary entry;
+		Array params;
+	};
+	std::mutex explain_mutex;
+	std::deque<ExplainJob> explain_jobs;
+
+	// Compiled column-to-property bindings for execute_query_into, keyed by query and class
+	std::mutex mapping_mutex;
+	std::unordered_map<std::string, std::shared_ptr<ObjectMapping>> object_mappings;
+
+	// Turns a pqxx result into the rows returned to the caller
+	using ResultConverter = std::function<bool(const pqxx::result &p_result, Array &r_rows, String &r_error)>;
+
+	std::shared_ptr<ConnectionPool> get_pool() const;
+	std::shared_ptr<ConnectionPool> _create_pool(const String &p_connection_string, int p_pool_size) const;
+	std::shared_ptr<ConnectionPool> get_shard_pool(const Variant &p_key, int &r_shard) const;
+	void _rebuild_shard_pools(const PackedStringArray &p_connection_strings, int p_pool_size);
+	void _run_shard_read(const std::shared_ptr<ShardScatter> &p_scatter, size_t p_index);
+	bool _execute_read(const std::shared_ptr<ConnectionPool> &p_pool, const String &p_query, const Array &p_params, Array &r_result, String &r_error);
+	bool _execute_query(const std::shared_ptr<ConnectionPool> &p_pool, const String &p_query, const Array &p_params, Array &r_result, String &r_error, const ResultConverter &p_converter = nullptr);
+	bool _execute_non_query(const std::shared_ptr<ConnectionPool> &p_pool, const String &p_query, const Array &p_params, int &r_affected_rows, String &r_error);
+
+	void _submit_task(const Callable &p_task);
+	void _wait_for_pending_tasks();
+	void _update_worker_count();
+	void _run_query_task(const String &p_query, const Array &p_params, int64_t p_request_id, int p_priority);
+	void _run_non_query_task(const String &p_query, const Array &p_params, int64_t p_request_id, int p_priority);
+
+	void _note_query_timing(const std::shared_ptr<ConnectionPool> &p_pool, const String &p_query, const Array &p_params, uint64_t p_duration_usec, uint64_t p_wait_usec, int64_t p_rows);
+	void _run_explain_jobs();
+	void _publish_slow_query(const Dictionary &p_entry);
+
+	void _schedule_dispatch();
+	void _dispatch_pending();
+
+	// Prints only with verbose_logging on. Arguments are converted to Variants
+	// only when printing, so the query hot path pays nothing when it is off.
+	template <typename... Args>
+	void _log_verbose(const Args &...p_args) const {
+		if (verbose_logging.load(std::memory_order_relaxed)) {
+			UtilityFunctions::print(p_args...);
+		}
+	}
+
+	// Signals may be raised from worker threads; listeners always run on the main thread.
+	template <typename... Args>
+	void emit_signal_threadsafe(const StringName &p_signal, const Args &...p_args) {
+		OS *os = OS::get_singleton();
+		if (os->get_thread_caller_id() == os->get_main_thread_id()) {
+			emit_signal(p_signal, p_args...);
+		} else {
+			Array args;
+			(args.push_back(Variant(p_args)), ...);
+			dispatcher.push_signal(p_signal, args, 0);
+			_schedule_dispatch();
+		}
+	}
 	
 protected:
 		static void _bind_methods();
@@ -35,11 +162,41 @@ public:
 		String get_connection_string() const;
 	void set_pool_size(int p_pool_size);
 	int get_pool_size() const;
+	void set_acquire_timeout_ms(int p_timeout_ms);
+	int get_acquire_timeout_ms() const;
+	void set_verbose_logging(bool p_enabled);
+	bool get_verbose_logging() const;
+	void set_dispatch_budget_usec(int p_usec);
+	int get_dispatch_budget_usec() const;
+	void set_result_chunk_size(int p_rows);
+	int get_result_chunk_size() const;
+	// Growth events of the per-connection scratch buffers (debug builds only)
+	int64_t get_scratch_growth_count() const;
+	void set_coalesce_reads(bool p_enabled);
+	bool get_coalesce_reads() const;
+	// Slow-query log
+	void set_slow_query_threshold_ms(double p_threshold_ms);
+	double get_slow_query_threshold_ms() const;
+	void set_slow_query_log_size(int p_size);
+	int get_slow_query_log_size() const;
+	void set_capture_explain(bool p_enabled);
+	bool get_capture_explain() const;
+	Array get_slow_queries();
+	void clear_slow_queries();
+	// Workload recording
+	bool start_recording(const String &p_path);
+	bool stop_recording();
+	bool is_recording() const;
+	// Chrome trace / Perfetto export of query timelines
+	bool start_trace(const String &p_path);
+	bool stop_trace();
+	bool is_tracing() const;
 	String _to_string() const;
 		bool connect_to_db();
 		void disconnect_from_db();
 	
 		Array execute_query(const String &p_query, const Array& p_params = Array());
+		Array execute_query_into(const Variant &p_class_or_script, const String &p_query, const Array& p_params = Array());
 		int execute_non_query(const String &p_query, const Array& p_params = Array());
 		
 		// Transaction support
@@ -49,9 +206,18 @@ public:
 		Array execute_query_in_transaction(const String &p_query, const Array& p_params = Array());
 		int execute_non_query_in_transaction(const String &p_query, const Array& p_params = Array());
 		
+		// Sharded mode
+		void set_shard_connection_strings(const PackedStringArray &p_connection_strings);
+		PackedStringArray get_shard_connection_strings() const;
+		int get_shard_count() const;
+		int get_shard_for_key(const Variant &p_key) const;
+		Array execute_query_sharded(const Variant &p_key, const String &p_query, const Array& p_params = Array());
+		int execute_non_query_sharded(const Variant &p_key, const String &p_query, const Array& p_params = Array());
+		Array execute_query_all_shards(const String &p_query, const Array& p_params = Array());
+		
 		// Async query support
-		void execute_query_async(const String &p_query, const Array& p_params = Array());
-		void execute_non_query_async(const String &p_query, const Array& p_params = Array());
+		int64_t execute_query_async(const String &p_query, const Array& p_params = Array(), int p_priority = 0);
+		int64_t execute_non_query_async(const String &p_query, const Array& p_params = Array(), int p_priority = 0);
 
 	// Signals for error reporting
 	void _query_failed(const String &p_query, const String &p_error_message);
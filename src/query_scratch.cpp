@@ -0,0 +1,235 @@
+#include "query_scratch.h"
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/vector2.hpp>
+#include <godot_cpp/variant/vector3.hpp>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace godot {
+
+#ifdef DEBUG_ENABLED
+static std::atomic<uint64_t> scratch_allocations{ 0 };
+#define COUNT_GROWTH(m_before, m_after) \
+    if ((m_after) > (m_before)) { scratch_allocations.fetch_add(1, std::memory_order_relaxed); }
+#else
+// Still consume the arguments so release builds have no unused variables
+#define COUNT_GROWTH(m_before, m_after) ((void)(m_before), (void)(m_after))
+#endif
+
+static void append_utf8(const String& p_string, std::string& r_out) {
+    const char32_t* chars = p_string.ptr();
+    int64_t length = p_string.length();
+    for (int64_t i = 0; i < length; ++i) {
+        uint32_t c = chars[i];
+        if (c < 0x80) {
+            r_out.push_back((char)c);
+        } else if (c < 0x800) {
+            r_out.push_back((char)(0xC0 | (c >> 6)));
+            r_out.push_back((char)(0x80 | (c & 0x3F)));
+        } else if (c < 0x10000) {
+            r_out.push_back((char)(0xE0 | (c >> 12)));
+            r_out.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+            r_out.push_back((char)(0x80 | (c & 0x3F)));
+        } else {
+            r_out.push_back((char)(0xF0 | (c >> 18)));
+            r_out.push_back((char)(0x80 | ((c >> 12) & 0x3F)));
+            r_out.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+            r_out.push_back((char)(0x80 | (c & 0x3F)));
+        }
+    }
+}
+
+static void append_int(int64_t p_value, std::string& r_out) {
+    char buffer[24];
+    std::to_chars_result res = std::to_chars(buffer, buffer + sizeof(buffer), p_value);
+    r_out.append(buffer, res.ptr - buffer);
+}
+
+// Shortest text that parses back to the same value, so 19.99 is sent as
+// "19.99" rather than "19.989999999999998". std::to_chars for floating point
+// is not available on every toolchain we ship for, so try increasing
+// precision until the value round-trips.
+static void append_shortest(double p_value, bool p_single, std::string& r_out) {
+    char buffer[32];
+    int written = 0;
+    const int max_digits = p_single ? 9 : 17;
+    for (int digits = p_single ? 6 : 15; digits <= max_digits; ++digits) {
+        written = std::snprintf(buffer, sizeof(buffer), "%.*g", digits, p_value);
+        if (digits == max_digits) {
+            break;
+        }
+        bool round_trips = p_single ? std::strtof(buffer, nullptr) == (float)p_value : std::strtod(buffer, nullptr) == p_value;
+        if (round_trips) {
+            break;
+        }
+    }
+    r_out.append(buffer, written);
+}
+
+void QueryScratch::append_real(double p_value, std::string& r_out) {
+    append_shortest(p_value, false, r_out);
+}
+
+void QueryScratch::append_vector_component(real_t p_value, std::string& r_out) {
+    // Vector components are single precision unless Godot is built with double reals
+    append_shortest(p_value, sizeof(real_t) == sizeof(float), r_out);
+}
+
+pqxx::zview QueryScratch::encode_query(const String& p_query) {
+    size_t before = query_text.capacity();
+    query_text.clear();
+    append_utf8(p_query, query_text);
+    COUNT_GROWTH(before, query_text.capacity());
+    return pqxx::zview(query_text);
+}
+
+bool QueryScratch::encode_params(const Array& p_params, String& r_error) {
+    param_count = (int)p_params.size();
+    if ((int)param_values.size() < param_count) {
+        COUNT_GROWTH(param_values.capacity(), (size_t)param_count);
+        param_values.resize(param_count);
+        param_is_null.resize(param_count);
+    }
+
+    for (int i = 0; i < param_count; ++i) {
+        const Variant& param = p_params[i];
+        std::string& out = param_values[i];
+        size_t before = out.capacity();
+        out.clear();
+        param_is_null[i] = false;
+
+        switch (param.get_type()) {
+            case Variant::NIL:
+                param_is_null[i] = true;
+                break;
+            case Variant::INT:
+                append_int(param.operator int64_t(), out);
+                break;
+            case Variant::STRING:
+            case Variant::STRING_NAME:
+                append_utf8(param.operator String(), out);
+                break;
+            case Variant::FLOAT:
+                append_real(param.operator double(), out);
+                break;
+            case Variant::BOOL:
+                out.append(param.operator bool() ? "true" : "false");
+                break;
+            case Variant::VECTOR2: {
+                Vector2 v = param.operator Vector2();
+                out.push_back('(');
+                append_vector_component(v.x, out);
+                out.push_back(',');
+                append_vector_component(v.y, out);
+                out.push_back(')');
+            } break;
+            case Variant::VECTOR3: {
+                Vector3 v = param.operator Vector3();
+                out.push_back('(');
+                append_vector_component(v.x, out);
+                out.push_back(',');
+                append_vector_component(v.y, out);
+                out.push_back(',');
+                append_vector_component(v.z, out);
+                out.push_back(')');
+            } break;
+            default:
+                r_error = String("Unsupported parameter type: ") + Variant::get_type_name(param.get_type());
+                return false;
+        }
+        COUNT_GROWTH(before, out.capacity());
+    }
+    return true;
+}
+
+pqxx::params QueryScratch::build_params() const {
+    pqxx::params params;
+    params.reserve(param_count);
+    for (int i = 0; i < param_count; ++i) {
+        if (param_is_null[i]) {
+            params.append();
+        } else {
+            // zview does not copy; the scratch strings outlive the statement
+            params.append(pqxx::zview(param_values[i]));
+        }
+    }
+    return params;
+}
+
+bool QueryScratch::is_ddl() const {
+    static const char* const ddl_keywords[] = { "CREATE", "DROP", "ALTER", "TRUNCATE" };
+    size_t start = query_text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return false;
+    }
+    for (const char* keyword : ddl_keywords) {
+        size_t length = std::strlen(keyword);
+        if (query_text.size() - start < length) {
+            continue;
+        }
+        bool match = true;
+        for (size_t i = 0; i < length && match; ++i) {
+            char c = query_text[start + i];
+            if (c >= 'a' && c <= 'z') {
+                c = (char)(c - 'a' + 'A');
+            }
+            match = c == keyword[i];
+        }
+        if (match) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void QueryScratch::prepare_columns(const pqxx::result& p_result) {
+    int columns = (int)p_result.columns();
+    if ((int)column_keys.size() != columns) {
+        COUNT_GROWTH(column_keys.capacity(), (size_t)columns);
+        column_keys.resize(columns);
+        column_names.resize(columns);
+    }
+    for (int c = 0; c < columns; ++c) {
+        const char* name = p_result.column_name(c);
+        // Only intern again when the column actually changed
+        if (column_keys[c] != name) {
+            size_t before = column_keys[c].capacity();
+            column_keys[c].assign(name);
+            COUNT_GROWTH(before, column_keys[c].capacity());
+            column_names[c] = StringName(String::utf8(name));
+#ifdef DEBUG_ENABLED
+            scratch_allocations.fetch_add(1, std::memory_order_relaxed);
+#endif
+        }
+    }
+}
+
+void QueryScratch::convert_result(const pqxx::result& p_result, Array& r_rows) {
+    prepare_columns(p_result);
+    int columns = (int)column_names.size();
+    int64_t base = r_rows.size();
+    r_rows.resize(base + (int64_t)p_result.size());
+
+    int64_t index = base;
+    for (pqxx::row const& row : p_result) {
+        Dictionary godot_row;
+        for (int c = 0; c < columns; ++c) {
+            pqxx::field const field = row[c];
+            godot_row[column_names[c]] = String::utf8(field.c_str(), (int64_t)field.size());
+        }
+        r_rows[index++] = godot_row;
+    }
+}
+
+uint64_t QueryScratch::get_growth_count() {
+#ifdef DEBUG_ENABLED
+    return scratch_allocations.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+}
@@ -0,0 +1,62 @@
+#ifndef QUERY_SCRATCH_H
+#define QUERY_SCRATCH_H
+
+#include <godot_cpp/core/math_defs.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/string.hpp>
+#include <godot_cpp/variant/string_name.hpp>
+#include <pqxx/pqxx>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace godot {
+
+// Reusable buffers for one pooled connection. Query text, parameters and
+// column names are encoded into storage that keeps its capacity between
+// calls, so a steady stream of similar queries no longer reallocates them.
+// The pqxx::params list and the result are still allocated per call.
+class QueryScratch {
+private:
+    std::string query_text;
+    std::vector<std::string> param_values;
+    std::vector<bool> param_is_null;
+    int param_count = 0;
+
+    // Column names of the last result, interned once and shared by every row
+    std::vector<std::string> column_keys;
+    std::vector<StringName> column_names;
+
+    void prepare_columns(const pqxx::result& p_result);
+
+public:
+    // Encodes the query text once; the returned view stays valid until the next call.
+    pqxx::zview encode_query(const String& p_query);
+
+    // Encodes p_params into the scratch buffers. Returns false and sets
+    // r_error for types that cannot be bound.
+    bool encode_params(const Array& p_params, String& r_error);
+    pqxx::params build_params() const;
+    int get_param_count() const { return param_count; }
+
+    // True for statements that do not report affected rows (CREATE, DROP,
+    // ALTER, TRUNCATE). Looks at the text from the last encode_query().
+    bool is_ddl() const;
+
+    // Converts every row into a Dictionary keyed by the interned column names.
+    void convert_result(const pqxx::result& p_result, Array& r_rows);
+
+    // Number of times any scratch buffer had to grow. Only counted in debug
+    // builds; always 0 in release builds. Allocations outside the scratch
+    // buffers (parameter list, result rows) are not included.
+    static uint64_t get_growth_count();
+
+    // Shortest decimal text that reads back as the same value
+    static void append_real(double p_value, std::string& r_out);
+    // Same at the precision of a Vector2/Vector3 component
+    static void append_vector_component(real_t p_value, std::string& r_out);
+};
+
+}
+
+#endif
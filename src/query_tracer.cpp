@@ -0,0 +1,263 @@
+#include "query_tracer.h"
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace godot {
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start_usec;
+    uint64_t duration_usec;
+    uint32_t query_hash;
+    int64_t rows;
+};
+
+// Single-producer/single-consumer ring: the owning thread pushes, the flush
+// on the main thread pops. When the ring is full new events are dropped
+// rather than blocking the query.
+struct ThreadBuffer {
+    static constexpr uint64_t CAPACITY = 4096; // Power of two
+    TraceEvent events[CAPACITY];
+    std::atomic<uint64_t> head{ 0 };
+    std::atomic<uint64_t> tail{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+    uint32_t thread_index = 0;
+    bool named = false;
+    // Owning thread has exited; recycled once its events are written out
+    bool retired = false;
+};
+
+std::atomic<bool> enabled{ false };
+const std::chrono::steady_clock::time_point clock_origin = std::chrono::steady_clock::now();
+uint64_t trace_origin_usec = 0;
+uint64_t last_flush_usec = 0;
+bool first_event = true;
+
+// Buffers of live threads, plus those of exited threads whose events have
+// not been flushed yet. Drained buffers of exited threads move to
+// free_buffers and are handed to the next thread that records a span, so
+// short-lived threads do not grow the registry.
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+std::vector<std::unique_ptr<ThreadBuffer>> free_buffers;
+uint32_t next_thread_index = 0;
+// Drop counts of buffers that left the registry during this trace
+uint64_t retired_dropped = 0;
+Ref<FileAccess> trace_file;
+
+const uint64_t FLUSH_INTERVAL_USEC = 250000;
+const size_t MAX_FREE_BUFFERS = 16;
+
+// Caller holds registry_mutex. The buffer must be drained.
+void recycle_buffer(size_t p_index) {
+    std::unique_ptr<ThreadBuffer> buffer = std::move(registry[p_index]);
+    registry[p_index] = std::move(registry.back());
+    registry.pop_back();
+    retired_dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+    if (free_buffers.size() < MAX_FREE_BUFFERS) {
+        free_buffers.push_back(std::move(buffer));
+    }
+}
+
+// Caller holds registry_mutex
+void recycle_drained_buffers() {
+    for (size_t i = 0; i < registry.size();) {
+        ThreadBuffer* buffer = registry[i].get();
+        if (buffer->retired && buffer->tail.load(std::memory_order_relaxed) == buffer->head.load(std::memory_order_acquire)) {
+            recycle_buffer(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+// Hands the thread's buffer back when the thread exits
+struct LocalBufferOwner {
+    ThreadBuffer* buffer = nullptr;
+
+    ~LocalBufferOwner() {
+        if (!buffer) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        buffer->retired = true;
+        if (!enabled.load()) {
+            // Nobody will flush these any more
+            buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+        }
+        recycle_drained_buffers();
+    }
+};
+
+thread_local LocalBufferOwner local_owner;
+
+ThreadBuffer* get_local_buffer() {
+    if (!local_owner.buffer) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        std::unique_ptr<ThreadBuffer> buffer;
+        if (!free_buffers.empty()) {
+            buffer = std::move(free_buffers.back());
+            free_buffers.pop_back();
+        } else {
+            buffer = std::make_unique<ThreadBuffer>();
+        }
+        // A recycled buffer gets a fresh track in the trace
+        buffer->thread_index = ++next_thread_index;
+        buffer->named = false;
+        buffer->retired = false;
+        local_owner.buffer = buffer.get();
+        registry.push_back(std::move(buffer));
+    }
+    return local_owner.buffer;
+}
+
+void append_event_json(std::string& r_out, const char* p_format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, p_format);
+    int written = std::vsnprintf(line, sizeof(line), p_format, args);
+    va_end(args);
+    if (written <= 0) {
+        return;
+    }
+    if (!first_event) {
+        r_out.append(",\n");
+    }
+    first_event = false;
+    r_out.append(line, written < (int)sizeof(line) ? written : (int)sizeof(line) - 1);
+}
+
+// Caller holds registry_mutex
+void drain_buffers() {
+    if (trace_file.is_null()) {
+        return;
+    }
+    std::string out;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : registry) {
+        uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        if (tail == head) {
+            continue;
+        }
+        if (!buffer->named) {
+            append_event_json(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"PostgreAdapter thread %u\"}}",
+                    buffer->thread_index, buffer->thread_index);
+            buffer->named = true;
+        }
+        for (; tail != head; ++tail) {
+            const TraceEvent& event = buffer->events[tail & (ThreadBuffer::CAPACITY - 1)];
+            append_event_json(out, "{\"name\":\"%s\",\"cat\":\"postgres\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%llu,\"args\":{\"query_hash\":\"%08x\",\"rows\":%lld}}",
+                    event.name, buffer->thread_index,
+                    (unsigned long long)(event.start_usec - trace_origin_usec),
+                    (unsigned long long)event.duration_usec,
+                    event.query_hash, (long long)event.rows);
+        }
+        buffer->tail.store(tail, std::memory_order_release);
+    }
+    if (!out.empty()) {
+        trace_file->store_string(String::utf8(out.data(), (int64_t)out.size()));
+    }
+    recycle_drained_buffers();
+}
+
+}
+
+uint64_t QueryTracer::now_usec() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - clock_origin).count();
+}
+
+bool QueryTracer::is_enabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void QueryTracer::record(const char* p_name, uint64_t p_start_usec, uint64_t p_end_usec, uint32_t p_query_hash, int64_t p_rows) {
+    ThreadBuffer* buffer = get_local_buffer();
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    uint64_t tail = buffer->tail.load(std::memory_order_acquire);
+    if (head - tail >= ThreadBuffer::CAPACITY) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceEvent& event = buffer->events[head & (ThreadBuffer::CAPACITY - 1)];
+    event.name = p_name;
+    event.start_usec = p_start_usec;
+    event.duration_usec = p_end_usec - p_start_usec;
+    event.query_hash = p_query_hash;
+    event.rows = p_rows;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+bool QueryTracer::start(const String& p_path) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    if (enabled.load()) {
+        UtilityFunctions::print("Trace already running.");
+        return false;
+    }
+    trace_file = FileAccess::open(p_path, FileAccess::WRITE);
+    if (trace_file.is_null()) {
+        UtilityFunctions::print("Failed to open trace file: ", p_path);
+        return false;
+    }
+    // Discard anything left over from a previous session
+    for (const std::unique_ptr<ThreadBuffer>& buffer : registry) {
+        buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->named = false;
+    }
+    recycle_drained_buffers();
+    retired_dropped = 0;
+    trace_origin_usec = now_usec();
+    last_flush_usec = trace_origin_usec;
+    first_event = true;
+    trace_file->store_string("{\"traceEvents\":[\n");
+    enabled.store(true);
+    UtilityFunctions::print("Query trace started: ", p_path);
+    return true;
+}
+
+bool QueryTracer::stop() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    if (!enabled.load()) {
+        return false;
+    }
+    enabled.store(false);
+    drain_buffers();
+    uint64_t dropped = retired_dropped;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : registry) {
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    trace_file->store_string("\n],\"displayTimeUnit\":\"ms\"}\n");
+    trace_file->close();
+    trace_file.unref();
+    if (dropped > 0) {
+        UtilityFunctions::print("Query trace stopped. Dropped events (buffer full): ", (int64_t)dropped);
+    } else {
+        UtilityFunctions::print("Query trace stopped.");
+    }
+    return true;
+}
+
+void QueryTracer::flush_if_due() {
+    if (!is_enabled()) {
+        return;
+    }
+    uint64_t now = now_usec();
+    if (now - last_flush_usec < FLUSH_INTERVAL_USEC) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    last_flush_usec = now;
+    drain_buffers();
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef QUERY_TRACER_H
+#define QUERY_TRACER_H
+
+#include <godot_cpp/variant/string.hpp>
+#include <cstdint>
+
+namespace godot {
+
+// Records timed spans of the query pipeline into per-thread ring buffers and
+// writes them out as Chrome trace JSON (chrome://tracing, Perfetto).
+// Recording a span is a couple of atomic loads and stores on the calling
+// thread; only the flush, which runs on the main thread, touches the file.
+class QueryTracer {
+public:
+    static bool start(const String& p_path);
+    static bool stop();
+    static bool is_enabled();
+
+    // Writes out buffered events. Cheap to call every frame; it only does
+    // work every few hundred milliseconds.
+    static void flush_if_due();
+
+    // Hash that tags a statement's spans; 0 without hashing while tracing is off
+    static uint32_t query_hash(const String& p_query) { return is_enabled() ? p_query.hash() : 0; }
+
+    static uint64_t now_usec();
+    static void record(const char* p_name, uint64_t p_start_usec, uint64_t p_end_usec, uint32_t p_query_hash, int64_t p_rows);
+};
+
+// Times the enclosing scope. p_name must be a string literal.
+class TraceSpan {
+private:
+    const char* name;
+    uint64_t start_usec = 0;
+    uint32_t query_hash;
+    int64_t rows = -1;
+    bool active;
+
+public:
+    TraceSpan(const char* p_name, uint32_t p_query_hash = 0) :
+            name(p_name), query_hash(p_query_hash), active(QueryTracer::is_enabled()) {
+        if (active) {
+            start_usec = QueryTracer::now_usec();
+        }
+    }
+
+    ~TraceSpan() {
+        if (active) {
+            QueryTracer::record(name, start_usec, QueryTracer::now_usec(), query_hash, rows);
+        }
+    }
+
+    void set_rows(int64_t p_rows) { rows = p_rows; }
+};
+
+}
+
+#endif
@@ -0,0 +1,110 @@
+#include "query_workers.h"
+#include <algorithm>
+
+namespace godot {
+
+QueryWorkers::~QueryWorkers() {
+    stop();
+}
+
+void QueryWorkers::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        work_available.wait(lock, [this] { return stopping || !jobs.empty() || live_count > target_count; });
+        if (live_count > target_count || (stopping && jobs.empty())) {
+            --live_count;
+            exited.push_back(std::this_thread::get_id());
+            idle.notify_all();
+            return;
+        }
+        std::function<void()> job = std::move(jobs.front());
+        jobs.pop_front();
+        ++busy_count;
+        lock.unlock();
+        job();
+        lock.lock();
+        --busy_count;
+        if (jobs.empty() && busy_count == 0) {
+            idle.notify_all();
+        }
+    }
+}
+
+void QueryWorkers::spawn_needed() {
+    // Start another thread only while queued jobs outnumber idle threads
+    while (!stopping && live_count < target_count && live_count - busy_count < (int)jobs.size()) {
+        threads.emplace_back(&QueryWorkers::run, this);
+        ++live_count;
+    }
+}
+
+std::vector<std::thread> QueryWorkers::take_exited() {
+    std::vector<std::thread> finished;
+    for (const std::thread::id& id : exited) {
+        auto it = std::find_if(threads.begin(), threads.end(), [&id](const std::thread& t) { return t.get_id() == id; });
+        if (it != threads.end()) {
+            finished.push_back(std::move(*it));
+            threads.erase(it);
+        }
+    }
+    exited.clear();
+    return finished;
+}
+
+void QueryWorkers::set_thread_count(int p_count) {
+    std::vector<std::thread> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        target_count = std::max(1, p_count);
+        finished = take_exited();
+        spawn_needed();
+    }
+    // Wakes surplus idle threads so they exit
+    work_available.notify_all();
+    for (std::thread& thread : finished) {
+        thread.join();
+    }
+}
+
+int QueryWorkers::get_thread_count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return target_count;
+}
+
+void QueryWorkers::submit(std::function<void()> p_job) {
+    std::vector<std::thread> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(p_job));
+        finished = take_exited();
+        spawn_needed();
+    }
+    work_available.notify_one();
+    for (std::thread& thread : finished) {
+        thread.join();
+    }
+}
+
+void QueryWorkers::wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return jobs.empty() && busy_count == 0; });
+}
+
+void QueryWorkers::stop() {
+    std::vector<std::thread> all;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        all.swap(threads);
+    }
+    work_available.notify_all();
+    for (std::thread& thread : all) {
+        thread.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    exited.clear();
+    live_count = 0;
+    stopping = false;
+}
+
+}
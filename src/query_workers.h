@@ -0,0 +1,55 @@
+#ifndef QUERY_WORKERS_H
+#define QUERY_WORKERS_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace godot {
+
+// Dedicated threads for blocking database calls. Each job holds a thread for
+// a full server round trip, so these run apart from the engine's
+// WorkerThreadPool: they neither starve engine tasks nor fall under its
+// low-priority thread cap. Threads start on demand up to the configured
+// count, and surplus threads exit when the count is lowered.
+class QueryWorkers {
+private:
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable idle;
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> threads;
+    // Threads that left run() and still need to be joined
+    std::vector<std::thread::id> exited;
+    int target_count = 4;
+    int live_count = 0;
+    int busy_count = 0;
+    bool stopping = false;
+
+    void run();
+    // Caller holds mutex
+    void spawn_needed();
+    // Caller holds mutex; returns the exited threads so they can be joined outside it
+    std::vector<std::thread> take_exited();
+
+public:
+    ~QueryWorkers();
+
+    void set_thread_count(int p_count);
+    int get_thread_count();
+
+    void submit(std::function<void()> p_job);
+    // Blocks until the queue is empty and no job is running, including jobs
+    // queued by other jobs.
+    void wait_idle();
+    // Finishes queued jobs, then joins every thread. submit() starts fresh
+    // threads afterwards.
+    void stop();
+};
+
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include "result_dispatcher.h"
+#include <chrono>
+
+namespace godot {
+
+void ResultDispatcher::push(Delivery& delivery) {
+    std::lock_guard<std::mutex> lock(mutex);
+    delivery.sequence = next_sequence++;
+    queue.push(delivery);
+}
+
+void ResultDispatcher::push_signal(const StringName& p_signal, const Array& p_args, int p_priority) {
+    Delivery delivery;
+    delivery.priority = p_priority;
+    delivery.signal = p_signal;
+    delivery.args = p_args;
+    push(delivery);
+}
+
+void ResultDispatcher::push_request_signal(const StringName& p_signal, const StringName& p_request_signal, int64_t p_request_id, const Array& p_args, int p_priority) {
+    Delivery delivery;
+    delivery.priority = p_priority;
+    delivery.signal = p_signal;
+    delivery.request_signal = p_request_signal;
+    delivery.request_id = p_request_id;
+    delivery.args = p_args;
+    push(delivery);
+}
+
+void ResultDispatcher::push_result(int64_t p_request_id, const Array& p_rows, int p_priority) {
+    Delivery delivery;
+    delivery.priority = p_priority;
+    delivery.is_result = true;
+    delivery.request_id = p_request_id;
+    delivery.rows = p_rows;
+    push(delivery);
+}
+
+bool ResultDispatcher::is_empty() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.empty();
+}
+
+void ResultDispatcher::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue = decltype(queue)();
+}
+
+bool ResultDispatcher::drain(Object* p_target, uint64_t p_budget_usec, int p_chunk_size) {
+    using clock = std::chrono::steady_clock;
+    const clock::time_point start = clock::now();
+
+    while (true) {
+        Delivery delivery;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (queue.empty()) {
+                return false;
+            }
+            delivery = queue.top();
+            queue.pop();
+        }
+
+        if (!delivery.is_result) {
+            Array call_args;
+            call_args.push_back(delivery.signal);
+            call_args.append_array(delivery.args);
+            p_target->callv("emit_signal", call_args);
+            if (!delivery.request_signal.is_empty()) {
+                call_args[0] = delivery.request_signal;
+                call_args.insert(1, delivery.request_id);
+                p_target->callv("emit_signal", call_args);
+            }
+        } else {
+            int64_t total = delivery.rows.size();
+            int64_t end = total;
+            if (p_chunk_size > 0 && total - delivery.next_row > p_chunk_size) {
+                end = delivery.next_row + p_chunk_size;
+            }
+            bool is_last = end >= total;
+            Array chunk = (delivery.next_row == 0 && is_last) ? delivery.rows : delivery.rows.slice(delivery.next_row, end);
+            p_target->emit_signal("query_chunk_received", delivery.request_id, chunk, is_last);
+            if (is_last) {
+                p_target->emit_signal("query_completed", delivery.rows);
+                p_target->emit_signal("query_request_completed", delivery.request_id, delivery.rows);
+            } else {
+                // Requeue with the original sequence so it keeps its place in line
+                delivery.next_row = end;
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push(delivery);
+            }
+        }
+
+        uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+        if (elapsed >= p_budget_usec) {
+            return !is_empty();
+        }
+    }
+}
+
+}
@@ -0,0 +1,68 @@
+#ifndef RESULT_DISPATCHER_H
+#define RESULT_DISPATCHER_H
+
+#include <godot_cpp/core/object.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/string_name.hpp>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+namespace godot {
+
+// Collects results and signal emissions produced on worker threads and hands
+// them to the main thread a little at a time, so a burst of finished queries
+// never lands in a single frame.
+class ResultDispatcher {
+public:
+    struct Delivery {
+        int priority = 0;
+        uint64_t sequence = 0;
+        // Plain signal emission
+        StringName signal;
+        Array args;
+        // Optional companion signal emitted right after it with the request id prepended
+        StringName request_signal;
+        // Query result, emitted in row chunks when is_result is set
+        bool is_result = false;
+        int64_t request_id = 0;
+        Array rows;
+        int64_t next_row = 0;
+    };
+
+private:
+    struct Compare {
+        bool operator()(const Delivery& a, const Delivery& b) const {
+            // Higher priority first, FIFO within the same priority
+            if (a.priority != b.priority) {
+                return a.priority < b.priority;
+            }
+            return a.sequence > b.sequence;
+        }
+    };
+
+    std::priority_queue<Delivery, std::vector<Delivery>, Compare> queue;
+    std::mutex mutex;
+    uint64_t next_sequence = 0;
+
+    void push(Delivery& delivery);
+
+public:
+    void push_signal(const StringName& p_signal, const Array& p_args, int p_priority);
+    // Emits p_signal(args...) followed by p_request_signal(request_id, args...)
+    void push_request_signal(const StringName& p_signal, const StringName& p_request_signal, int64_t p_request_id, const Array& p_args, int p_priority);
+    void push_result(int64_t p_request_id, const Array& p_rows, int p_priority);
+    bool is_empty();
+    void clear();
+
+    // Emits queued signals on p_target until p_budget_usec is spent. At least
+    // one delivery is made per call so the queue always makes progress.
+    // Results larger than p_chunk_size rows are split across calls; 0 sends
+    // them whole. Returns true if work is left over for the next frame.
+    bool drain(Object* p_target, uint64_t p_budget_usec, int p_chunk_size);
+};
+
+}
+
+#endif
@@ -0,0 +1,73 @@
+#include "single_flight.h"
+
+namespace godot {
+
+std::shared_ptr<SingleFlight::Call> SingleFlight::join(const std::string& p_key, bool& r_leader) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<Call>& call = calls[p_key];
+    r_leader = !call;
+    if (r_leader) {
+        call = std::make_shared<Call>();
+    }
+    return call;
+}
+
+void SingleFlight::finish(const std::string& p_key, const std::shared_ptr<Call>& p_call, bool p_ok, const Array& p_result, const String& p_error) {
+    {
+        // Unregister first so callers arriving from now on start a fresh query
+        std::lock_guard<std::mutex> lock(mutex);
+        calls.erase(p_key);
+    }
+    std::lock_guard<std::mutex> lock(p_call->mutex);
+    p_call->ok = p_ok;
+    p_call->result = p_result;
+    p_call->error = p_error;
+    p_call->done = true;
+    p_call->condition.notify_all();
+}
+
+void SingleFlight::wait(Call& p_call) {
+    std::unique_lock<std::mutex> lock(p_call.mutex);
+    p_call.condition.wait(lock, [&p_call] { return p_call.done; });
+}
+
+bool SingleFlight::is_plain_read(const String& p_query) {
+    // INTO covers SELECT INTO, UPDATE and SHARE cover the FOR ... row locks,
+    // and the write keywords catch data-modifying CTEs.
+    static const char* const unsafe_words[] = { "INSERT", "UPDATE", "DELETE", "MERGE", "INTO", "SHARE", "NEXTVAL", "SETVAL", "COPY", "CALL" };
+
+    CharString utf8 = p_query.utf8();
+    const char* c = utf8.get_data();
+    bool first_word = true;
+    std::string word;
+    while (true) {
+        char ch = *c;
+        bool word_char = (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') || ch == '_' || ch == '$';
+        if (word_char) {
+            word.push_back(ch >= 'a' && ch <= 'z' ? (char)(ch - 'a' + 'A') : ch);
+        } else if (!word.empty()) {
+            if (first_word) {
+                if (word != "SELECT" && word != "WITH") {
+                    return false;
+                }
+                first_word = false;
+            }
+            for (const char* unsafe : unsafe_words) {
+                if (word == unsafe) {
+                    return false;
+                }
+            }
+            word.clear();
+        } else if (first_word && ch != '\0' && ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n' && ch != '(') {
+            // Leading comments or anything unexpected: do not guess
+            return false;
+        }
+        if (ch == '\0') {
+            break;
+        }
+        ++c;
+    }
+    return !first_word;
+}
+
+}
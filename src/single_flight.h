@@ -0,0 +1,50 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/string.hpp>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace godot {
+
+// Coalesces identical reads that are in flight at the same time. The first
+// caller for a key runs the query; callers that arrive before it finishes
+// wait for it and receive the same result. Nothing is cached once the
+// leader has finished.
+class SingleFlight {
+public:
+    struct Call {
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool done = false;
+        bool ok = false;
+        Array result;
+        String error;
+    };
+
+private:
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<Call>> calls;
+
+public:
+    // Returns the call registered for p_key. r_leader is true when the caller
+    // created it and must run the query and then call finish().
+    std::shared_ptr<Call> join(const std::string& p_key, bool& r_leader);
+    void finish(const std::string& p_key, const std::shared_ptr<Call>& p_call, bool p_ok, const Array& p_result, const String& p_error);
+    // Blocks until the leader has finished p_call
+    static void wait(Call& p_call);
+
+    // True if p_query is safe to coalesce: it starts with SELECT or WITH and
+    // contains no keyword that writes, locks rows or advances a sequence.
+    // Errs on the side of false; functions with side effects called from a
+    // SELECT cannot be detected.
+    static bool is_plain_read(const String& p_query);
+};
+
+}
+
+#endif
@@ -0,0 +1,46 @@
+#include "slow_query_log.h"
+
+namespace godot {
+
+void SlowQueryLog::add(const Dictionary& p_entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capacity <= 0) {
+        return;
+    }
+    while ((int)entries.size() >= capacity) {
+        entries.pop_front();
+    }
+    entries.push_back(p_entry);
+}
+
+Array SlowQueryLog::get_entries() {
+    std::lock_guard<std::mutex> lock(mutex);
+    Array result;
+    result.resize((int64_t)entries.size());
+    int64_t index = 0;
+    for (const Dictionary& entry : entries) {
+        // Copies, so callers cannot edit the log behind its lock
+        result[index++] = entry.duplicate();
+    }
+    return result;
+}
+
+void SlowQueryLog::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
+
+void SlowQueryLog::set_capacity(int p_capacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = p_capacity > 0 ? p_capacity : 0;
+    while ((int)entries.size() > capacity) {
+        entries.pop_front();
+    }
+}
+
+int SlowQueryLog::get_capacity() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return capacity;
+}
+
+}
@@ -0,0 +1,30 @@
+#ifndef SLOW_QUERY_LOG_H
+#define SLOW_QUERY_LOG_H
+
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <deque>
+#include <mutex>
+
+namespace godot {
+
+// Bounded, thread-safe log of statements that crossed the slow-query
+// threshold. The oldest entry is dropped once the log is full.
+class SlowQueryLog {
+private:
+    std::deque<Dictionary> entries;
+    mutable std::mutex mutex;
+    int capacity = 100;
+
+public:
+    void add(const Dictionary& p_entry);
+    Array get_entries();
+    void clear();
+
+    void set_capacity(int p_capacity);
+    int get_capacity() const;
+};
+
+}
+
+#endif
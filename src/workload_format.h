@@ -0,0 +1,65 @@
+#ifndef WORKLOAD_FORMAT_H
+#define WORKLOAD_FORMAT_H
+
+#include <cstdint>
+
+// Binary layout of workload recordings written by PostgreAdapter and read by
+// tools/workload_replay.cpp. All integers are little-endian.
+//
+//   header:  "PGWL" u16 version u16 reserved
+//   record:  u8 api, u64 offset_usec (since recording started),
+//            u32 sql_length, sql bytes (UTF-8),
+//            u16 param_count, params
+//   param:   u8 tag, then i64 (INT), f64 (FLOAT), u8 (BOOL),
+//            u32 length + UTF-8 bytes (TEXT), nothing for NULL
+//
+// This header is shared with the standalone replay tool and must not depend
+// on godot-cpp.
+
+namespace workload {
+
+static const char MAGIC[4] = { 'P', 'G', 'W', 'L' };
+static const uint16_t VERSION = 1;
+
+enum Api : uint8_t {
+    API_QUERY = 1,
+    API_NON_QUERY = 2,
+    API_QUERY_ASYNC = 3,
+    API_NON_QUERY_ASYNC = 4,
+    API_BEGIN_TRANSACTION = 5,
+    API_COMMIT_TRANSACTION = 6,
+    API_ROLLBACK_TRANSACTION = 7,
+    API_QUERY_IN_TRANSACTION = 8,
+    API_NON_QUERY_IN_TRANSACTION = 9,
+};
+
+enum ParamTag : uint8_t {
+    PARAM_NULL = 0,
+    PARAM_INT = 1,
+    PARAM_FLOAT = 2,
+    PARAM_BOOL = 3,
+    PARAM_TEXT = 4,
+};
+
+inline bool is_transaction_api(uint8_t p_api) {
+    return p_api >= API_BEGIN_TRANSACTION && p_api <= API_NON_QUERY_IN_TRANSACTION;
+}
+
+inline const char* api_name(uint8_t p_api) {
+    switch (p_api) {
+        case API_QUERY: return "query";
+        case API_NON_QUERY: return "non_query";
+        case API_QUERY_ASYNC: return "query_async";
+        case API_NON_QUERY_ASYNC: return "non_query_async";
+        case API_BEGIN_TRANSACTION: return "begin_transaction";
+        case API_COMMIT_TRANSACTION: return "commit_transaction";
+        case API_ROLLBACK_TRANSACTION: return "rollback_transaction";
+        case API_QUERY_IN_TRANSACTION: return "query_in_transaction";
+        case API_NON_QUERY_IN_TRANSACTION: return "non_query_in_transaction";
+    }
+    return "unknown";
+}
+
+}
+
+#endif
@@ -0,0 +1,152 @@
+#include "workload_recorder.h"
+#include "query_scratch.h"
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <godot_cpp/variant/vector2.hpp>
+#include <godot_cpp/variant/vector3.hpp>
+#include <cstring>
+
+namespace godot {
+
+static const size_t FLUSH_THRESHOLD = 64 * 1024;
+
+template <typename T>
+static void put(std::string& r_out, T p_value) {
+    // Recordings are little-endian; every platform we ship for is as well.
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &p_value, sizeof(T));
+    r_out.append(bytes, sizeof(T));
+}
+
+static void put_text(std::string& r_out, const char* p_text, size_t p_length) {
+    put<uint32_t>(r_out, (uint32_t)p_length);
+    r_out.append(p_text, p_length);
+}
+
+static void put_text(std::string& r_out, const String& p_text) {
+    CharString utf8 = p_text.utf8();
+    put_text(r_out, utf8.get_data(), utf8.length());
+}
+
+WorkloadRecorder::~WorkloadRecorder() {
+    stop();
+}
+
+bool WorkloadRecorder::start(const String& p_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (recording.load()) {
+        UtilityFunctions::print("Workload recording already running.");
+        return false;
+    }
+    file = FileAccess::open(p_path, FileAccess::WRITE);
+    if (file.is_null()) {
+        UtilityFunctions::print("Failed to open workload recording: ", p_path);
+        return false;
+    }
+    buffer.clear();
+    buffer.append(workload::MAGIC, sizeof(workload::MAGIC));
+    put<uint16_t>(buffer, workload::VERSION);
+    put<uint16_t>(buffer, 0);
+    origin.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    recording.store(true, std::memory_order_release);
+    UtilityFunctions::print("Workload recording started: ", p_path);
+    return true;
+}
+
+bool WorkloadRecorder::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!recording.load()) {
+        return false;
+    }
+    recording.store(false);
+    flush_buffer();
+    file->close();
+    file.unref();
+    UtilityFunctions::print("Workload recording stopped.");
+    return true;
+}
+
+// Caller holds mutex
+void WorkloadRecorder::flush_buffer() {
+    if (buffer.empty() || file.is_null()) {
+        return;
+    }
+    PackedByteArray bytes;
+    bytes.resize((int64_t)buffer.size());
+    std::memcpy(bytes.ptrw(), buffer.data(), buffer.size());
+    file->store_buffer(bytes);
+    buffer.clear();
+}
+
+void WorkloadRecorder::record(workload::Api p_api, const String& p_query, const Array& p_params) {
+    if (!is_recording()) {
+        return;
+    }
+    std::chrono::steady_clock::time_point started{ std::chrono::steady_clock::duration(origin.load(std::memory_order_relaxed)) };
+    uint64_t offset_usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+
+    // Encode outside the lock; only the append is serialized
+    std::string entry;
+    put<uint8_t>(entry, p_api);
+    put<uint64_t>(entry, offset_usec);
+    put_text(entry, p_query);
+    put<uint16_t>(entry, (uint16_t)p_params.size());
+    for (int64_t i = 0; i < p_params.size(); ++i) {
+        const Variant& param = p_params[i];
+        switch (param.get_type()) {
+            case Variant::NIL:
+                put<uint8_t>(entry, workload::PARAM_NULL);
+                break;
+            case Variant::INT:
+                put<uint8_t>(entry, workload::PARAM_INT);
+                put<int64_t>(entry, param.operator int64_t());
+                break;
+            case Variant::FLOAT:
+                put<uint8_t>(entry, workload::PARAM_FLOAT);
+                put<double>(entry, param.operator double());
+                break;
+            case Variant::BOOL:
+                put<uint8_t>(entry, workload::PARAM_BOOL);
+                put<uint8_t>(entry, param.operator bool() ? 1 : 0);
+                break;
+            case Variant::VECTOR2: {
+                // Stored as the text the adapter binds
+                Vector2 v = param.operator Vector2();
+                std::string text = "(";
+                QueryScratch::append_vector_component(v.x, text);
+                text.push_back(',');
+                QueryScratch::append_vector_component(v.y, text);
+                text.push_back(')');
+                put<uint8_t>(entry, workload::PARAM_TEXT);
+                put_text(entry, text.data(), text.size());
+            } break;
+            case Variant::VECTOR3: {
+                Vector3 v = param.operator Vector3();
+                std::string text = "(";
+                QueryScratch::append_vector_component(v.x, text);
+                text.push_back(',');
+                QueryScratch::append_vector_component(v.y, text);
+                text.push_back(',');
+                QueryScratch::append_vector_component(v.z, text);
+                text.push_back(')');
+                put<uint8_t>(entry, workload::PARAM_TEXT);
+                put_text(entry, text.data(), text.size());
+            } break;
+            default:
+                put<uint8_t>(entry, workload::PARAM_TEXT);
+                put_text(entry, param.stringify());
+                break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!recording.load()) {
+        return;
+    }
+    buffer.append(entry);
+    if (buffer.size() >= FLUSH_THRESHOLD) {
+        flush_buffer();
+    }
+}
+
+}
@@ -0,0 +1,44 @@
+#ifndef WORKLOAD_RECORDER_H
+#define WORKLOAD_RECORDER_H
+
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/string.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include "workload_format.h"
+
+namespace godot {
+
+// Appends every adapter call to a compact binary recording (see
+// workload_format.h) that tools/workload_replay.cpp can run again later.
+// Calls may come from any thread; records are buffered and written in
+// batches under a mutex.
+class WorkloadRecorder {
+private:
+    std::atomic<bool> recording{ false };
+    std::mutex mutex;
+    Ref<FileAccess> file;
+    std::string buffer;
+    // steady_clock ticks at start(); atomic because record() reads it without
+    // the mutex and a stop()/start() pair can rewrite it meanwhile
+    std::atomic<std::chrono::steady_clock::rep> origin{ 0 };
+
+    void flush_buffer();
+
+public:
+    ~WorkloadRecorder();
+
+    bool start(const String& p_path);
+    bool stop();
+    // Acquire pairs with the store in start() so origin is visible once this returns true
+    bool is_recording() const { return recording.load(std::memory_order_acquire); }
+
+    void record(workload::Api p_api, const String& p_query = String(), const Array& p_params = Array());
+};
+
+}
+
+#endif
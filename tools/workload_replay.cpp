@@ -0,0 +1,395 @@
+// Replays a workload recording made with PostgreAdapter.start_recording()
+// against a PostgreSQL server and reports throughput and latency.
+//
+// Build:  scons workload_replay
+// Usage:  workload_replay <recording> <connection_string> [--speed N] [--concurrency N]
+//
+//   --speed N        Replay N times faster than recorded (default 1).
+//                    0 ignores the recorded timing and runs as fast as possible.
+//                    With a schedule, latency counts from each call's due time.
+//   --concurrency N  Worker connections for non-transactional calls (default 4).
+//
+// Transactional calls are replayed in order on one extra connection, like the
+// adapter's single transaction.
+
+#include <pqxx/pqxx>
+#include "workload_format.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Param {
+    bool is_null = false;
+    std::string text;
+};
+
+struct Record {
+    uint8_t api = 0;
+    uint64_t offset_usec = 0;
+    std::string sql;
+    std::vector<Param> params;
+};
+
+struct Sample {
+    uint8_t api;
+    uint64_t latency_usec;
+    bool ok;
+};
+
+class Reader {
+private:
+    const std::vector<char>& data;
+    size_t position = 0;
+
+public:
+    explicit Reader(const std::vector<char>& p_data) :
+            data(p_data) {}
+
+    bool at_end() const { return position >= data.size(); }
+
+    template <typename T>
+    bool get(T& r_value) {
+        if (data.size() - position < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&r_value, data.data() + position, sizeof(T));
+        position += sizeof(T);
+        return true;
+    }
+
+    bool get_text(std::string& r_text) {
+        uint32_t length = 0;
+        if (!get(length) || data.size() - position < length) {
+            return false;
+        }
+        r_text.assign(data.data() + position, length);
+        position += length;
+        return true;
+    }
+};
+
+bool load_recording(const char* p_path, std::vector<Record>& r_records) {
+    std::ifstream file(p_path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open recording: " << p_path << std::endl;
+        return false;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    Reader reader(data);
+
+    char magic[4] = {};
+    uint16_t version = 0;
+    uint16_t reserved = 0;
+    if (!reader.get(magic) || !reader.get(version) || !reader.get(reserved) || std::memcmp(magic, workload::MAGIC, sizeof(magic)) != 0) {
+        std::cerr << "Not a workload recording: " << p_path << std::endl;
+        return false;
+    }
+    if (version != workload::VERSION) {
+        std::cerr << "Unsupported recording version " << version << std::endl;
+        return false;
+    }
+
+    while (!reader.at_end()) {
+        Record record;
+        uint16_t param_count = 0;
+        if (!reader.get(record.api) || !reader.get(record.offset_usec) || !reader.get_text(record.sql) || !reader.get(param_count)) {
+            std::cerr << "Truncated record " << r_records.size() << ", stopping there." << std::endl;
+            break;
+        }
+        bool ok = true;
+        record.params.resize(param_count);
+        for (Param& param : record.params) {
+            uint8_t tag = 0;
+            ok = reader.get(tag);
+            if (!ok) {
+                break;
+            }
+            char buffer[32];
+            switch (tag) {
+                case workload::PARAM_NULL:
+                    param.is_null = true;
+                    break;
+                case workload::PARAM_INT: {
+                    int64_t value = 0;
+                    ok = reader.get(value);
+                    param.text = std::to_string(value);
+                } break;
+                case workload::PARAM_FLOAT: {
+                    double value = 0;
+                    ok = reader.get(value);
+                    // Shortest text that round-trips, as the adapter binds it
+                    for (int digits = 15; digits <= 17; ++digits) {
+                        std::snprintf(buffer, sizeof(buffer), "%.*g", digits, value);
+                        if (std::strtod(buffer, nullptr) == value) {
+                            break;
+                        }
+                    }
+                    param.text = buffer;
+                } break;
+                case workload::PARAM_BOOL: {
+                    uint8_t value = 0;
+                    ok = reader.get(value);
+                    param.text = value ? "true" : "false";
+                } break;
+                case workload::PARAM_TEXT:
+                    ok = reader.get_text(param.text);
+                    break;
+                default:
+                    ok = false;
+                    break;
+            }
+            if (!ok) {
+                break;
+            }
+        }
+        if (!ok) {
+            std::cerr << "Malformed parameters in record " << r_records.size() << ", stopping there." << std::endl;
+            break;
+        }
+        r_records.push_back(std::move(record));
+    }
+    return true;
+}
+
+pqxx::result run_statement(pqxx::transaction_base& p_tx, const Record& p_record) {
+    if (p_record.params.empty()) {
+        return p_tx.exec(p_record.sql);
+    }
+    pqxx::params params;
+    params.reserve(p_record.params.size());
+    for (const Param& param : p_record.params) {
+        if (param.is_null) {
+            params.append();
+        } else {
+            params.append(pqxx::zview(param.text));
+        }
+    }
+    return p_tx.exec_params(p_record.sql, params);
+}
+
+class Replayer {
+private:
+    const std::vector<Record>& records;
+    std::string connection_string;
+    double speed;
+    Clock::time_point start;
+
+    std::atomic<size_t> next_record{ 0 };
+    std::mutex samples_mutex;
+    std::vector<Sample> samples;
+
+    // Sleeps until the record is due and returns the time latency is measured
+    // from. With a schedule that is the due time, so time spent queued behind
+    // busy workers counts as latency, as it would have for the original caller.
+    Clock::time_point wait_for_schedule(const Record& p_record) {
+        if (speed <= 0.0) {
+            return Clock::now();
+        }
+        Clock::time_point due = start + std::chrono::microseconds((uint64_t)(p_record.offset_usec / speed));
+        std::this_thread::sleep_until(due);
+        return due;
+    }
+
+    void add_samples(std::vector<Sample>& p_local) {
+        std::lock_guard<std::mutex> lock(samples_mutex);
+        samples.insert(samples.end(), p_local.begin(), p_local.end());
+        p_local.clear();
+    }
+
+    // Non-transactional calls: workers take records in recorded order
+    void run_worker() {
+        std::unique_ptr<pqxx::connection> conn;
+        try {
+            conn = std::make_unique<pqxx::connection>(connection_string);
+        } catch (const std::exception& e) {
+            std::cerr << "Worker failed to connect: " << e.what() << std::endl;
+            return;
+        }
+        std::vector<Sample> local;
+        while (true) {
+            size_t index = next_record.fetch_add(1);
+            if (index >= records.size()) {
+                break;
+            }
+            const Record& record = records[index];
+            if (workload::is_transaction_api(record.api)) {
+                continue;
+            }
+            Clock::time_point begin = wait_for_schedule(record);
+            bool ok = true;
+            try {
+                pqxx::work tx(*conn);
+                run_statement(tx, record);
+                tx.commit();
+            } catch (const pqxx::broken_connection&) {
+                ok = false;
+                try {
+                    conn = std::make_unique<pqxx::connection>(connection_string);
+                } catch (const std::exception& e) {
+                    std::cerr << "Worker lost its connection: " << e.what() << std::endl;
+                    local.push_back({ record.api, 0, false });
+                    break;
+                }
+            } catch (const std::exception&) {
+                ok = false;
+            }
+            uint64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - begin).count();
+            local.push_back({ record.api, latency, ok });
+        }
+        add_samples(local);
+    }
+
+    // Transactional calls replay in order on their own connection
+    void run_transaction_lane() {
+        std::unique_ptr<pqxx::connection> conn;
+        try {
+            conn = std::make_unique<pqxx::connection>(connection_string);
+        } catch (const std::exception& e) {
+            std::cerr << "Transaction lane failed to connect: " << e.what() << std::endl;
+            return;
+        }
+        std::unique_ptr<pqxx::work> tx;
+        std::vector<Sample> local;
+        for (const Record& record : records) {
+            if (!workload::is_transaction_api(record.api)) {
+                continue;
+            }
+            Clock::time_point begin = wait_for_schedule(record);
+            bool ok = true;
+            try {
+                switch (record.api) {
+                    case workload::API_BEGIN_TRANSACTION:
+                        if (!tx) {
+                            tx = std::make_unique<pqxx::work>(*conn);
+                        }
+                        break;
+                    case workload::API_COMMIT_TRANSACTION:
+                        if (tx) {
+                            tx->commit();
+                            tx.reset();
+                        }
+                        break;
+                    case workload::API_ROLLBACK_TRANSACTION:
+                        if (tx) {
+                            tx->abort();
+                            tx.reset();
+                        }
+                        break;
+                    default:
+                        ok = tx != nullptr;
+                        if (ok) {
+                            run_statement(*tx, record);
+                        }
+                        break;
+                }
+            } catch (const std::exception&) {
+                // A failed statement aborts the server-side transaction, as it did when recorded
+                ok = false;
+                tx.reset();
+            }
+            uint64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - begin).count();
+            local.push_back({ record.api, latency, ok });
+        }
+        add_samples(local);
+    }
+
+public:
+    Replayer(const std::vector<Record>& p_records, const std::string& p_connection_string, double p_speed) :
+            records(p_records), connection_string(p_connection_string), speed(p_speed) {}
+
+    void run(int p_concurrency) {
+        start = Clock::now();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < p_concurrency; ++i) {
+            threads.emplace_back(&Replayer::run_worker, this);
+        }
+        threads.emplace_back(&Replayer::run_transaction_lane, this);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void report() {
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        size_t failures = 0;
+        std::vector<uint64_t> latencies;
+        latencies.reserve(samples.size());
+        size_t per_api[16] = {};
+        for (const Sample& sample : samples) {
+            latencies.push_back(sample.latency_usec);
+            failures += sample.ok ? 0 : 1;
+            per_api[sample.api & 15]++;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p) -> double {
+            if (latencies.empty()) {
+                return 0.0;
+            }
+            size_t index = std::min(latencies.size() - 1, (size_t)(p * (latencies.size() - 1) + 0.5));
+            return latencies[index] / 1000.0;
+        };
+
+        std::printf("Replayed %zu calls in %.3f s (%zu failed)\n", samples.size(), elapsed, failures);
+        std::printf("Throughput: %.1f calls/s\n", elapsed > 0 ? samples.size() / elapsed : 0.0);
+        std::printf("Latency ms: p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n",
+                percentile(0.50), percentile(0.95), percentile(0.99), percentile(1.0));
+        for (uint8_t api = workload::API_QUERY; api <= workload::API_NON_QUERY_IN_TRANSACTION; ++api) {
+            if (per_api[api] > 0) {
+                std::printf("  %-26s %zu\n", workload::api_name(api), per_api[api]);
+            }
+        }
+    }
+};
+
+void print_usage() {
+    std::cerr << "Usage: workload_replay <recording> <connection_string> [--speed N] [--concurrency N]" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+    double speed = 1.0;
+    int concurrency = 4;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--concurrency") == 0 && i + 1 < argc) {
+            concurrency = std::max(1, std::atoi(argv[++i]));
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    std::vector<Record> records;
+    if (!load_recording(argv[1], records)) {
+        return 1;
+    }
+    std::printf("Loaded %zu recorded calls, replaying at %s with %d workers\n",
+            records.size(), speed > 0 ? (std::to_string(speed) + "x").c_str() : "full speed", concurrency);
+
+    Replayer replayer(records, argv[2], speed);
+    replayer.run(concurrency);
+    replayer.report();
+    return 0;
+}